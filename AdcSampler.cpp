@@ -0,0 +1,150 @@
+#include "AdcSampler.h"
+#include "Elapsed.h"
+
+AdcSampler *AdcSampler::active = NULL;
+
+AdcSampler::AdcSampler(void)
+{
+  _count = 0;
+  _level = 0;
+  _valid = 0;
+  _running = false;
+}
+
+uint8_t AdcSampler::attach(uint8_t pin, uint16_t lowThreshold, uint16_t highThreshold)
+{
+  if (_count >= ADC_MAX_CHANNELS)
+    return 0xFF;
+
+  if (pin >= A0)
+    pin -= A0;
+  // AVcc reference like analogRead()
+  _mux[_count] = _BV(REFS0) | (pin & 0x07);
+  _low[_count] = lowThreshold;
+  _high[_count] = highThreshold;
+  return _count++;
+}
+
+void AdcSampler::begin(void)
+{
+  if (_count == 0)
+    return;
+
+  active = this;
+  // free running mode
+  ADCSRB = 0;
+  // enable, interrupt, prescaler 128
+  ADCSRA = _BV(ADEN) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+  _startWindow();
+}
+
+void AdcSampler::update(void)
+{
+  if (_count == 0 || _running ||
+      !elapsed(millis(), _windowStart, ADC_WINDOW_PERIOD))
+    return;
+
+  _startWindow();
+}
+
+uint16_t AdcSampler::nextUpdate(void)
+{
+  if (_count == 0)
+    return 0xFFFF;
+
+  return remaining(millis(), _windowStart, ADC_WINDOW_PERIOD);
+}
+
+uint16_t AdcSampler::value(uint8_t channel)
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  uint16_t value = _value[channel];
+  SREG = oldSREG;
+  return value >> 2;
+}
+
+bool AdcSampler::isHigh(uint8_t channel)
+{
+  return _level & _BV(channel);
+}
+
+bool AdcSampler::ready(void)
+{
+  return _valid == _BV(_count) - 1;
+}
+
+void AdcSampler::handleInterrupt(void)
+{
+  uint16_t sample = ADC;
+
+  // conversion which was started before the window ended
+  if (!_running)
+    return;
+
+  // the first conversion after switching still used previous channel
+  if (_skip) {
+    _skip = false;
+    return;
+  }
+
+  _sum += sample;
+  if (++_samples < ADC_OVERSAMPLING)
+    return;
+
+  // decimate to 12 bits
+  uint16_t decimated = _sum >> 2;
+  uint8_t channel = _channel;
+  uint8_t bit = _BV(channel);
+  uint16_t value = _value[channel];
+
+  if (_valid & bit) {
+    // exponential smoothing, 1/4 of new value
+    value = value - (value >> 2) + (decimated >> 2);
+  } else {
+    value = decimated;
+    _valid |= bit;
+  }
+  _value[channel] = value;
+
+  // hysteresis in analogRead() scale
+  value >>= 2;
+  if (value > _high[channel])
+    _level |= bit;
+  else if (value < _low[channel])
+    _level &= ~bit;
+
+  // move to next channel, takes effect on the next conversion
+  if (++_channel >= _count)
+    _channel = 0;
+  ADMUX = _mux[_channel];
+  _samples = 0;
+  _sum = 0;
+  _skip = true;
+
+  // every channel has a new value, stop till next window
+  if (_channel == 0)
+  {
+    ADCSRA &= ~_BV(ADATE);
+    _running = false;
+  }
+}
+
+void AdcSampler::_startWindow(void)
+{
+  _windowStart = millis();
+  _channel = 0;
+  _samples = 0;
+  _sum = 0;
+  _skip = true;
+  ADMUX = _mux[0];
+  _running = true;
+  // start free running conversions
+  ADCSRA |= _BV(ADSC) | _BV(ADATE);
+}
+
+ISR(ADC_vect)
+{
+  if (AdcSampler::active)
+    AdcSampler::active->handleInterrupt();
+}
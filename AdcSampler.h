@@ -0,0 +1,79 @@
+#ifndef AdcSampler_h
+#define AdcSampler_h
+
+#include <Arduino.h>
+
+// Background sampling of analog inputs by ADC interrupt.
+// The ADC runs free during a window, channels are sampled round-robin,
+// every value is oversampled and decimated to 12 bits, then smoothed.
+// Levels have hysteresis between low and high thresholds. The ADC
+// stops between windows, so its interrupt (9.6 kHz with prescaler 128)
+// doesn't wake the idle MCU. Window takes 17 conversions of 104 us
+// per channel, 3.5 ms for two channels every second.
+
+// Maximum of sampled channels
+#ifndef ADC_MAX_CHANNELS
+#define ADC_MAX_CHANNELS 4
+#endif
+
+// Samples per value, 16 samples give 2 extra bits
+#define ADC_OVERSAMPLING 16
+
+// Period of sampling windows, ms
+#ifndef ADC_WINDOW_PERIOD
+#define ADC_WINDOW_PERIOD 1000
+#endif
+
+class AdcSampler
+{
+  public:
+    AdcSampler(void);
+
+    // Add analog pin with thresholds (0-1023) of level hysteresis.
+    // Returns channel index or 0xFF if there is no free channel.
+    uint8_t attach(uint8_t pin, uint16_t lowThreshold, uint16_t highThreshold);
+
+    // Start sampling, call it after all pins are attached
+    void begin(void);
+
+    // Start next window when its period has passed, call it from loop
+    void update(void);
+
+    // Milliseconds till update() starts next window
+    uint16_t nextUpdate(void);
+
+    // Smoothed value of channel in analogRead() scale (0-1023)
+    uint16_t value(uint8_t channel);
+
+    // Returns true when value has passed the high threshold and
+    // doesn't fall under the low threshold yet
+    bool isHigh(uint8_t channel);
+
+    // Returns true when every channel has a value
+    bool ready(void);
+
+    // ADC conversion complete interrupt handler
+    void handleInterrupt(void);
+
+    static AdcSampler *active;
+
+  private:
+    uint8_t _mux[ADC_MAX_CHANNELS];
+    uint16_t _low[ADC_MAX_CHANNELS];
+    uint16_t _high[ADC_MAX_CHANNELS];
+    // smoothed values in 12 bits scale
+    volatile uint16_t _value[ADC_MAX_CHANNELS];
+    volatile uint8_t _level;
+    volatile uint8_t _valid;
+    uint8_t _count;
+    uint8_t _channel;
+    uint8_t _samples;
+    uint16_t _sum;
+    bool _skip;
+    volatile bool _running;
+    unsigned long _windowStart;
+
+    void _startWindow(void);
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef ALARMS_H
+#define ALARMS_H
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+#include "Uptime.h"
+
+//#define DEBUG_ALARMS
+
+// Alarm codes are bits 1-31, higher bit is more important.
+// Bits from 16 are errors, bits below are warnings and infos.
+static const uint8_t NO_ALARM = 0;
+static const uint8_t ALARM_CODES = 24;
+static const uint32_t ALARM_ERRORS = 0xFFFF0000;
+static const uint32_t ALARM_WARNINGS = 0x0000FFFE;
+
+#define ALARM_BIT(code) ((uint32_t)1 << (code))
+
+// Set of alarms. Every alarm is raised and cleared by its own check,
+// so concurrent faults don't overwrite each other. Latching alarms stay
+// pending after the condition is gone until they are acknowledged.
+class Alarms
+{
+public:
+  uint32_t active; // conditions present now
+  uint32_t pending; // active and latched, not acknowledged
+
+  Alarms(uint32_t _latching) : active(0), pending(0), latching(_latching) {
+    memset(raisedAt, 0, sizeof(raisedAt));
+  }
+
+  void raise(uint8_t _code) {
+    uint32_t bit = ALARM_BIT(_code);
+    if((active & bit) == 0 && _code < ALARM_CODES) {
+      raisedAt[_code] = uptime.minutes();
+      #ifdef DEBUG_ALARMS
+        printf_P(PSTR("ALARMS: Info: Raised %d.\n\r"), _code);
+      #endif
+    }
+    active |= bit;
+    pending |= bit;
+  }
+
+  void clear(uint8_t _code) {
+    uint32_t bit = ALARM_BIT(_code);
+    #ifdef DEBUG_ALARMS
+      if(active & bit)
+        printf_P(PSTR("ALARMS: Info: Cleared %d after %u min.\n\r"),
+          _code, since(_code));
+    #endif
+    active &= ~bit;
+    if((latching & bit) == 0)
+      pending &= ~bit;
+  }
+
+  void set(uint8_t _code, bool _condition) {
+    if(_condition)
+      raise(_code);
+    else
+      clear(_code);
+  }
+
+  bool isActive(uint8_t _code) {
+    return active & ALARM_BIT(_code);
+  }
+
+  // Drop latched alarms which are gone
+  void acknowledge() {
+    pending = active;
+  }
+
+  // Minutes from raise of the alarm
+  uint16_t since(uint8_t _code) {
+    if(_code >= ALARM_CODES)
+      return 0;
+    return (uint16_t)uptime.minutes() - raisedAt[_code];
+  }
+
+  // The most important pending alarm of group
+  uint8_t highest(uint32_t _mask) {
+    uint32_t bits = pending & _mask;
+    uint8_t* bytes = (uint8_t*)&bits;
+    // highest non zero byte (little endian), then nibble by table
+    for(int8_t i=3; i>=0; i--) {
+      uint8_t b = bytes[i];
+      if(b == 0)
+        continue;
+      if(b >= 16)
+        return i*8 + 4 + pgm_read_byte(&highestBit[b >> 4]);
+      return i*8 + pgm_read_byte(&highestBit[b]);
+    }
+    return NO_ALARM;
+  }
+
+  uint8_t error() {
+    return highest(ALARM_ERRORS);
+  }
+
+  uint8_t warning() {
+    return highest(ALARM_WARNINGS);
+  }
+
+private:
+  uint32_t latching;
+  uint16_t raisedAt[ALARM_CODES]; // minutes of uptime
+  static const uint8_t highestBit[16];
+};
+
+const uint8_t Alarms::highestBit[16] PROGMEM =
+  {0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3};
+
+#endif // __ALARMS_H__
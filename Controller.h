@@ -0,0 +1,371 @@
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include "States.h"
+#include "Beep.h"
+#include "Zone.h"
+#include "MistingControl.h"
+#include "Thermal.h"
+#include "Rules.h"
+#include "Profiles.h"
+
+//#define DEBUG_CONTROLLER
+
+// Watering, misting and light control of all zones. Settings, grow
+// profiles, states, alarms and rules are passed in and hardware is
+// reached through Hal, so several controllers can run in one process. Hal is a template
+// parameter, calls are resolved at compile time and inlined on AVR.
+//
+// Hal has to provide:
+//   unsigned long seconds();  uptime
+//   uint8_t hour(); uint8_t minute();  time of day
+//   bool relay(uint8_t output, bool on);  false if output is refused
+//   uint8_t zoneRelay(uint8_t zone, uint8_t relay);  output of zone
+//   void beep(uint8_t count);
+//   void settingsChanged();  settings have to be saved
+template<class Hal>
+class Controller
+{
+public:
+  ZoneState zones[ZONES];
+  unsigned long lastWatering; // any zone
+
+  Controller(Hal &_hal, SettingsStruct &_settings, Profiles &_profiles,
+      States &_states, Alarms &_alarms, RuleTable &_rules) : zones(),
+      lastWatering(0), hal(_hal), settings(_settings), profiles(_profiles),
+      states(_states), alarms(_alarms), rules(_rules), pumpArbiter(),
+      sunrise(0),
+      thermalLevel(THERMAL_NORMAL) {}
+
+  // Call every second
+  void update() {
+    for(uint8_t z=0; z<ZONES; z++) {
+      watering(z);
+      misting(z);
+    }
+  }
+
+  // Shed loads by thermal level of computer: lamp when it is hot, 
+  // misting when it is critical. Watering keeps going.
+  void throttle(uint8_t _level) {
+    thermalLevel = _level;
+    if(_level < THERMAL_HOT) {
+      return;
+    }
+    for(uint8_t z=0; z<ZONES; z++) {
+      relayOff(z, LAMP);
+    }
+  }
+
+  // Call every minute
+  void doWork() {
+    // follow humidity
+    if(alarms.isActive(ERROR_DHT) == false) {
+      mistingControl.update(states[HUMIDITY], 
+        profiles.get(P_HUMID_MINIMUM), profiles.get(P_HUMID_MAXIMUM));
+    }
+    nextWatering = 0xFFFF;
+    nextMisting = 0xFFFF;
+    evaluate();
+    for(uint8_t z=0; z<ZONES; z++) {
+      doZone(z, rules.results[RULE_MODE]);
+    }
+    // nearest start of any zone, 0 if no zone is scheduled
+    states[WATERING] = nextWatering == 0xFFFF ? 0 : nextWatering;
+    states[MISTING] = nextMisting == 0xFFFF ? 0 : nextMisting;
+  }
+
+  // Lamps of all zones follow the same light day
+  void doLight() { 
+    evaluate();
+    if(rules.results[RULE_DAWN]) {
+      watchSunrise();
+      // light day may be moved
+      evaluate();
+    } else {
+      // reset sunrise time
+      sunrise = 0;
+    }
+    bool on = rules.results[RULE_LAMP] && thermalLevel < THERMAL_HOT;
+    for(uint8_t z=0; z<ZONES; z++) {
+      doLamp(z, on);
+    }
+  }
+
+private:
+  Hal &hal;
+  SettingsStruct &settings;
+  Profiles &profiles;
+  States &states;
+  Alarms &alarms;
+  RuleTable &rules;
+  PumpArbiter pumpArbiter;
+  MistingControl mistingControl;
+  uint16_t sunrise;
+  uint16_t nextWatering, nextMisting; // minutes, nearest of zones
+  uint8_t thermalLevel;
+
+  // Relay states keep a bit per zone
+  void relayOn(uint8_t zone, uint8_t relay) {
+    uint8_t bit = 1 << zone;
+    if(states[relay] & bit) {
+      // relay is already on
+      return;
+    }
+    uint8_t output = hal.zoneRelay(zone, relay);
+    if(output == RELAY_NONE) {
+      return;
+    }
+    // pumps start one by one
+    if(relay != LAMP && pumpArbiter.grant(hal.seconds()) == false) {
+      return;
+    }
+    if(hal.relay(output, true)) {
+      #ifdef DEBUG_RELAY
+        printf_P(PSTR("RELAY: Info: '%d' of zone %d is enabled.\n\r"), 
+          relay, zone);
+      #endif
+      states[relay] |= bit;
+    }
+  }
+
+  void relayOff(uint8_t zone, uint8_t relay) {
+    uint8_t bit = 1 << zone;
+    if((states[relay] & bit) == 0) {
+      // relay is already off
+      return;
+    }
+    if(hal.relay(hal.zoneRelay(zone, relay), false)) {
+      #ifdef DEBUG_RELAY
+        printf_P(PSTR("RELAY: Info: '%d' of zone %d is disabled.\n\r"), 
+          relay, zone);
+      #endif
+      states[relay] &= ~bit;
+    }
+  }
+
+  // Rules see states compared with settings, they are evaluated again
+  // only if inputs have changed
+  void evaluate() {
+    RuleInput input;
+    uint8_t hour = hal.hour();
+    uint16_t dtime = hour*60+hal.minute();
+    uint16_t lightDayEnd = settings.lightDayStart+
+      (profiles.get(P_LIGHT_DURATION)*60);
+    input.flags = 0;
+    if(profiles.get(P_SILENT_MORNING) <= hour &&
+        hour < profiles.get(P_SILENT_EVENING))
+      input.flags |= IN_SILENT_DAY;
+    if(settings.lightDayStart <= dtime && dtime <= lightDayEnd)
+      input.flags |= IN_LIGHT_DAY;
+    if(states[AIR_TEMP] <= settings.airTempMinimum)
+      input.flags |= IN_AIR_COLD;
+    if(states[LIGHT] > profiles.get(P_LIGHT_MINIMUM))
+      input.flags |= IN_BRIGHT;
+    input.hour = hour;
+    input.lux = states[LIGHT];
+    input.airTemp = states[AIR_TEMP];
+    input.alarms = alarms.active;
+    rules.update(input);
+  }
+
+  void doZone(uint8_t zone, uint8_t mode) {
+    // don't use cold water
+    if(alarms.isActive(ERROR_DS18B20) == false &&
+        zones[zone].substrateTemp <= settings.subsTempMinimum) {
+      return;
+    }
+    // sunny time
+    if(mode == MODE_SUNNY) {
+      #ifdef DEBUG_CONTROLLER
+        printf_P(PSTR("Work: Info: Sunny time in zone %d.\n\r"), zone);
+      #endif
+      checkTimer(zone, profiles.get(P_WATERING_SUNNY, zone),
+        profiles.get(P_MISTING_SUNNY, zone));
+      return;
+    }
+    // night time
+    if(mode == MODE_NIGHT) {
+      #ifdef DEBUG_CONTROLLER
+        printf_P(PSTR("Work: Info: Night time in zone %d.\n\r"), zone);
+      #endif
+      // nothing, silent night
+      return;
+    }
+    // other time period
+    checkTimer(zone, profiles.get(P_WATERING_PERIOD, zone),
+      profiles.get(P_MISTING_PERIOD, zone));
+  }
+
+  void checkTimer(uint8_t _zone, uint8_t _wateringMinute, 
+      uint8_t _mistingMinute) {
+    ZoneState *zone = &zones[_zone];
+    // watering
+    unsigned long diff = (hal.seconds()-zone->lastWatering)/60;
+    if(_wateringMinute > diff)
+      diff = _wateringMinute-diff;
+    else
+      diff = 0;
+    nextWatering = min(nextWatering, diff);
+    #ifdef DEBUG_CONTROLLER
+      printf_P(PSTR("Work: Info: Watering after: %u min.\n\r"), diff);
+    #endif
+    if(_wateringMinute != 0 && diff == 0 && 
+        zone->watering.phase == WATERING_IDLE) {
+      zone->watering.start(hal.seconds());
+    }
+
+    // misting by humidity
+    uint16_t mistingMinute = mistingControl.interval(_mistingMinute);
+    diff = (hal.seconds()-zone->lastMisting)/60;
+    if(mistingMinute > diff)
+      diff = mistingMinute-diff;
+    else
+      diff = 0;
+    nextMisting = min(nextMisting, diff);
+    #ifdef DEBUG_CONTROLLER
+      printf_P(PSTR("Work: Info: Misting after: %u min.\n\r"), diff);
+    #endif
+    if(mistingMinute != 0 && diff == 0) {
+      zone->startMisting = 
+        mistingControl.duration(profiles.get(P_MISTING_DURATION, _zone));
+    }
+  }
+
+  // Light day starts an hour before sunrise watched for 30 min
+  void watchSunrise() {
+    uint16_t dtime = hal.hour()*60+hal.minute();
+    // save sunrise time
+    if(sunrise == 0) {
+      sunrise = dtime;
+      return;
+    }
+    if(sunrise+30 > dtime) {
+      return;
+    }
+    #ifdef DEBUG_CONTROLLER
+      printf_P(PSTR("Light: Info: Set new Day Start time: %02d:%02d.\n\r"), 
+      sunrise/60, sunrise%60);
+    #endif
+    // save to EEPROM if big difference (more than 30 min)
+    if(sunrise-90 > settings.lightDayStart || 
+        sunrise-30 < settings.lightDayStart) {
+      hal.settingsChanged();
+    }
+    // setup 1 hour earlier
+    settings.lightDayStart = sunrise-60;
+    // prevent rewrite, move to out of morning
+    sunrise += 300;
+  }
+
+  void doLamp(uint8_t zone, bool on) {
+    if(on)
+      relayOn(zone, LAMP);
+    else
+      relayOff(zone, LAMP);
+  }
+
+  void misting(uint8_t _zone) {
+    ZoneState *zone = &zones[_zone];
+    uint8_t bit = 1 << _zone;
+    // quick check, misting waits while computer is overheated
+    if(zone->startMisting == 0 || alarms.isActive(WARNING_NO_WATER) ||
+        thermalLevel >= THERMAL_CRITICAL) {
+      // stop misting
+      if(states[PUMP_MISTING] & bit) {
+        #ifdef DEBUG_CONTROLLER
+          printf_P(PSTR("Misting: Info: Stop misting in zone %d.\n\r"), _zone);
+        #endif
+        relayOff(_zone, PUMP_MISTING);
+        if(states[PUMP_MISTING] == 0)
+          alarms.clear(WARNING_MISTING);
+      }
+      return;
+    }
+    #ifdef DEBUG_CONTROLLER
+      printf_P(PSTR("Misting: Info: Misting in zone %d...\n\r"), _zone);
+    #endif
+    // announce misting first
+    if(alarms.isActive(WARNING_MISTING) == false) {
+      hal.beep(TWO_BEEP);
+      alarms.raise(WARNING_MISTING);
+      return;
+    }
+    relayOn(_zone, PUMP_MISTING);
+    // wait for turn of pump start
+    if((states[PUMP_MISTING] & bit) == 0) {
+      return;
+    }
+    zone->startMisting--;
+    zone->lastMisting = hal.seconds();
+  }
+
+  void watering(uint8_t _zone) {
+    ZoneState *zone = &zones[_zone];
+    // quick check
+    if(zone->watering.phase == WATERING_IDLE) {
+      return;
+    }
+    // emergency stop
+    if(alarms.isActive(ERROR_NO_SUBSTRATE)) {
+      #ifdef DEBUG_CONTROLLER
+        printf_P(PSTR("Watering: Error: Emergency stop watering.\n\r"));
+      #endif
+      relayOff(_zone, PUMP_WATERING);
+      return;    
+    }
+    bool delivered = alarms.isActive(INFO_SUBSTRATE_DELIVERED);
+    // substrate is still wet, period starts again without announce
+    if(zone->watering.skip(delivered)) {
+      #ifdef DEBUG_CONTROLLER
+        printf_P(PSTR("Watering: Info: Skip watering in zone %d, substrate is wet.\n\r"),
+          _zone);
+      #endif
+      zone->lastWatering = hal.seconds();
+      sessionOver();
+      return;
+    }
+    // announce watering first
+    if(zone->watering.active() && 
+        alarms.isActive(WARNING_WATERING) == false) {
+      hal.beep(ONE_BEEP);
+      alarms.raise(WARNING_WATERING);
+      return;
+    }
+    // rest longer if substrate tank is low
+    uint8_t minPause = alarms.isActive(WARNING_SUBSTRATE_LOW) ? 21 : MIN_PAUSE;
+    bool wasActive = zone->watering.active();
+    bool pump = zone->watering.update(hal.seconds(), delivered,
+      profiles.get(P_WATERING_DURATION, _zone)*60, minPause);
+    if(pump) {
+      #ifdef DEBUG_CONTROLLER
+        printf_P(PSTR("Watering: Info: Watering in zone %d...\n\r"), _zone);
+      #endif
+      zone->lastWatering = hal.seconds();
+      lastWatering = zone->lastWatering;
+      relayOn(_zone, PUMP_WATERING);
+      return;
+    }
+    relayOff(_zone, PUMP_WATERING);
+    if(wasActive == false || zone->watering.active()) {
+      return;
+    }
+    // session is over
+    #ifdef DEBUG_CONTROLLER
+      printf_P(PSTR("Watering: Info: Stop watering in zone %d after %u sec, total %lu sec.\n\r"),
+        _zone, zone->watering.pumpSeconds, zone->watering.totalPumpSeconds);
+    #endif
+    sessionOver();
+  }
+
+  // Warning is kept while any zone waters
+  void sessionOver() {
+    bool others = false;
+    for(uint8_t z=0; z<ZONES; z++)
+      others |= zones[z].watering.active();
+    if(others == false)
+      alarms.clear(WARNING_WATERING);
+  }
+};
+
+#endif // __CONTROLLER_H__
@@ -0,0 +1,125 @@
+#ifndef CROPCALENDAR_H
+#define CROPCALENDAR_H
+
+#include "Profiles.h"
+
+//#define DEBUG_CALENDAR
+
+// Parameters which go over to next phase day by day: photoperiod,
+// watering and misting. Others change at once with phase.
+static const uint16_t CALENDAR_BLENDED = PROFILE_BIT(P_LIGHT_DURATION) |
+  PROFILE_BIT(P_WATERING_DURATION) | PROFILE_BIT(P_WATERING_SUNNY) |
+  PROFILE_BIT(P_WATERING_PERIOD) | PROFILE_BIT(P_MISTING_DURATION) |
+  PROFILE_BIT(P_MISTING_SUNNY) | PROFILE_BIT(P_MISTING_PERIOD);
+
+// Grow calendar by days of RTC. Phases are profiles with days, plan
+// of settings keeps current phase and its first day. Values in blend
+// days of phase are computed once a day and kept as overlay of the
+// profile, so control reads them as any other profile value.
+class CropCalendar
+{
+public:
+  CropCalendar(SettingsStruct &_base, Profiles &_profiles) : base(_base),
+    profiles(_profiles), today(0) {}
+
+  // Start grow plan with phase from day
+  void start(uint8_t _profile, uint16_t _day) {
+    base.profile = _profile;
+    base.profileDay = _day;
+    today = _day;
+    resume();
+  }
+
+  // Back to grow plan after temporary profile
+  void resume() {
+    advance();
+    profiles.select(base.profile);
+    blend();
+  }
+
+  // Call with days of RTC once a day, returns true if plan has moved on
+  // and settings have to be saved. Days before start of plan are
+  // skipped, clock can be set back. Plan moves on under temporary
+  // profile too, it is selected on resume().
+  bool update(uint16_t _day) {
+    today = _day;
+    bool temporary = profiles.isTemporary();
+    bool changed = advance();
+    if(temporary) {
+      return changed;
+    }
+    if(changed) {
+      profiles.select(base.profile);
+    }
+    blend();
+    return changed;
+  }
+
+  // Base settings are changed, blended values follow them
+  void refresh() {
+    if(profiles.isTemporary() == false) {
+      blend();
+    }
+  }
+
+  // Day of current phase from 0, 0xFFFF if it isn't known yet
+  uint16_t phaseDay() {
+    if(today == 0 || today < base.profileDay) {
+      return 0xFFFF;
+    }
+    return today - base.profileDay;
+  }
+
+private:
+  SettingsStruct &base;
+  Profiles &profiles;
+  uint16_t today;
+  uint16_t values[PROFILE_SLOTS];
+
+  // Step over phases which have passed, true if any
+  bool advance() {
+    bool changed = false;
+    while(today >= base.profileDay) {
+      uint8_t days = pgm_read_byte(&profileTable[base.profile].days);
+      if(days == 0 || today - base.profileDay < days) {
+        break;
+      }
+      base.profile = pgm_read_byte(&profileTable[base.profile].next);
+      base.profileDay += days;
+      changed = true;
+    }
+    return changed;
+  }
+
+  void blend() {
+    uint16_t day = phaseDay();
+    uint8_t days = pgm_read_byte(&profileTable[base.profile].days);
+    uint8_t blend = pgm_read_byte(&profileTable[base.profile].blend);
+    if(day == 0xFFFF || blend == 0 || day + blend < days) {
+      profiles.overlay(0, NULL);
+      return;
+    }
+    uint8_t next = pgm_read_byte(&profileTable[base.profile].next);
+    // 1 on first day of blend, next phase would be blend+1
+    uint8_t step = min(day + blend + 1 - days, blend + 1);
+    for(uint8_t p=0; p<PROFILE_PARAMS; p++) {
+      if((CALENDAR_BLENDED & PROFILE_BIT(p)) == 0) {
+        continue;
+      }
+      uint8_t zones = p < PROFILE_PARAMS - ZONE_PARAMS ? 1 : ZONES;
+      for(uint8_t z=0; z<zones; z++) {
+        int16_t from = profiles.profileValue(base.profile, p, z);
+        int16_t to = profiles.profileValue(next, p, z);
+        values[Profiles::slot(p, z)] = from +
+          (int32_t)(to - from)*step/(blend + 1);
+      }
+    }
+    profiles.overlay(CALENDAR_BLENDED, values);
+    #ifdef DEBUG_CALENDAR
+      printf_P(PSTR("CALENDAR: Info: Day %u of phase %d, blend %d/%d, light %dh.\n\r"),
+        day, base.profile, step, blend + 1, values[P_LIGHT_DURATION]);
+    #endif
+  }
+};
+
+#endif // __CROPCALENDAR_H__
@@ -1,4 +1,14 @@
 #include "DS18B20.h"
+#include <avr/eeprom.h>
+
+// Raw value of failed measurement
+#define RAW_ERROR ((int16_t)0x8000)
+
+// Queued measurement states
+#define STATE_IDLE 0
+#define STATE_CONVERTING 1
+#define STATE_READING 2
+#define STATE_READY 3
 
 // Exception handler
 // Prints the line number of the exception and block the program, when the function returns false
@@ -13,15 +23,21 @@ void __check(bool value, uint16_t line)
 }
 
 // Constructor
-// Argument: Pointer to OneWire object
+// Arguments:
+// oneWire - Pointer to OneWire object
+// engine - Pointer to OneWireAsync object for queued measurements (optional)
 // Return: New DS18B20 object
-DS18B20::DS18B20(OneWire *oneWire)
+DS18B20::DS18B20(OneWire *oneWire, OneWireAsync *engine)
 {
   _oneWire = oneWire;
+  _engine = engine;
+  _state = STATE_IDLE;
   _quality = 0;
   _samePowerType = false;
   _powerType = false;
   _beginConversionTime = 0;
+  _eepromAddress = 0;
+  _count = 0;
 }
 
 // Setup for all ds19b20 sensors in 1-Wire bus.
@@ -39,15 +55,8 @@ bool DS18B20::begin(uint8_t quality)
   uint8_t devices = 0;
   uint8_t parasiteDevices = 0;
 
-  uint32_t beginResetTimeout = millis();
-
-  while(!_oneWire->reset())
-  {
-    uint32_t elapsedResetTimeout = millis() - beginResetTimeout;
-
-    if (elapsedResetTimeout > 1000)
-      return false;
-  }
+  if (!_reset())
+    return false;
 
   _oneWire->reset_search();
   while (_oneWire->search(address))
@@ -77,16 +86,115 @@ bool DS18B20::begin(uint8_t quality)
   return true;
 }
 
-// Request for temperature measurements on all devices
+// Setup for ds18b20 sensors from the ROM table cached in EEPROM.
+// Cached sensors are validated by select, the full search of 1-Wire bus
+// runs only when the table is missing or some sensor doesn't respond.
+// Arguments:
+// quality - measurement resolution in bits (from 9 to 12)
+// eepromAddress - EEPROM address of the ROM table
+// defaultRole - role of newly discovered sensors
+// Return:
+// true - if all operations were successful
+// false - when the bus is physically damaged
+//       - when devices not respond
+//       - when not detect any device
+bool DS18B20::begin(uint8_t quality, uint16_t eepromAddress, uint8_t defaultRole)
+{
+  _quality = constrain(quality, 9, 12);
+  _eepromAddress = eepromAddress;
+
+  if (!_reset())
+    return false;
+
+  // all devices get the same resolution by skip ROM
+  if (!_sendQuality(NULL))
+    return false;
+
+  // any parasite device holds the bus low
+  _powerType = _receivePowerType(NULL);
+  _samePowerType = true;
+
+  bool valid = _loadTable();
+  for (uint8_t i=0; valid && i<_count; i++)
+    valid = _readScratchpad(_sensors[i].address, &_raw[i]);
+
+  if (valid)
+    return true;
+
+  if (discover(defaultRole) == 0)
+    return false;
+
+  _saveTable();
+  return true;
+}
+
+// Search all ds18b20 sensors in 1-Wire bus and rebuild the ROM table.
+// Already known sensors keep their roles.
+// Argument: defaultRole - role of new sensors
+// Return: count of found sensors
+uint8_t DS18B20::discover(uint8_t defaultRole)
+{
+  DS18B20Sensor found[DS18B20_MAX_SENSORS];
+  uint8_t devices = 0;
+
+  _oneWire->reset_search();
+  while (devices < DS18B20_MAX_SENSORS && 
+      _oneWire->search(found[devices].address))
+  {
+    uint8_t *address = found[devices].address;
+
+    if (OneWire::crc8(address, 7) != address[7])
+      continue;
+
+    if (address[0] != 0x28)
+      continue;
+
+    found[devices].role = defaultRole;
+    for (uint8_t i=0; i<_count; i++)
+    {
+      if (memcmp(_sensors[i].address, address, 8) == 0)
+        found[devices].role = _sensors[i].role;
+    }
+    _raw[devices] = RAW_ERROR;
+    devices++;
+  }
+
+  memcpy(_sensors, found, sizeof(found));
+  _count = devices;
+
+  return devices;
+}
+
+// Request for temperature measurements on all devices.
+// With OneWireAsync engine the request is queued, update() reads all
+// sensors in the background when the measurement is completed.
 // Return:
 // - true - if operation were successful
 // - false - if devices have different ways of power (combinations of normal and parasite in one bus)
 //         - if devices not responding
+//         - if queued measurement is in progress
 bool DS18B20::request()
 {
   if (!_samePowerType)
     return false;
 
+  if (_engine)
+  {
+    if (_state == STATE_CONVERTING || _state == STATE_READING)
+      return false;
+
+    _buffer[0] = 0xcc;
+    _buffer[1] = 0x44;
+    _state = STATE_CONVERTING;
+    _beginConversionTime = millis();
+
+    if (_engine->start(_buffer, 2, 0, !_powerType, _onComplete, this))
+      return true;
+
+    _state = STATE_IDLE;
+    return false;
+  }
+
   if (!_oneWire->reset())
     return false;
 
@@ -140,9 +248,11 @@ bool DS18B20::request(const __FlashStringHelper *_address)
 // - false - the measurement wasn't completed
 bool DS18B20::available(void)
 {
-  uint32_t durationTime[] = {94, 188, 375, 750};
+  if (_engine)
+    return _state == STATE_READY;
+
   uint32_t elapsedTime = millis() - _beginConversionTime;
-  bool timeout = elapsedTime >= durationTime[_quality-9];
+  bool timeout = elapsedTime >= _conversionTime();
 
   if (_powerType)
   {
@@ -158,6 +268,39 @@ bool DS18B20::available(void)
   return false;
 }
 
+// Drives queued measurement, call it from loop.
+// Starts reading of sensors when the measurement is completed.
+void DS18B20::update(void)
+{
+  if (_state != STATE_CONVERTING || _engine->busy())
+    return;
+
+  if (millis() - _beginConversionTime < _conversionTime())
+    return;
+
+  _index = 0;
+  _failed = false;
+  _state = STATE_READING;
+
+  if (!_queueScratchpad())
+  {
+    for (uint8_t i=0; i<_count; i++)
+      _raw[i] = RAW_ERROR;
+    _failed = true;
+    _state = STATE_READY;
+  }
+}
+
+uint16_t DS18B20::nextUpdate(void)
+{
+  if (_state != STATE_CONVERTING)
+    return 0xFFFF;
+
+  uint32_t passed = millis() - _beginConversionTime;
+  uint16_t conversionTime = _conversionTime();
+  return passed < conversionTime ? conversionTime - passed : 0;
+}
+
 // Read temperature from device
 // Argument: Pointer to an array of device address
 // Return: temperature in degrees Celsius
@@ -168,22 +311,12 @@ bool DS18B20::available(void)
 // - when not detect device of thad address
 float DS18B20::readTemperature(uint8_t *address)
 {
-  uint8_t scratchpad[9];
+  int16_t raw;
 
-  if (!_sendCommand(address, 0xbe))
+  if (!_readScratchpad(address, &raw))
     return TEMP_ERROR;
 
-  _oneWire->read_bytes(scratchpad, 9);
-
-  if (OneWire::crc8(scratchpad, 8) != scratchpad[8])
-    return TEMP_ERROR;
-
-  float quality[] = {0.5, 0.25, 0.125, 0.0625};
-  uint8_t shift[] = {3, 2, 1, 0};
-  int16_t raw = word(scratchpad[1], scratchpad[0]);
-  raw >>= shift[_quality-9];
-
-  return raw * quality[_quality-9];
+  return raw * 0.0625f;
 }
 
 // Read temperature from device
@@ -202,13 +335,126 @@ float DS18B20::readTemperature(const __FlashStringHelper *_address)
   return readTemperature(address);
 }
 
+// Read scratchpads of all sensors from the ROM table in one pass,
+// call it once after request() for all devices. With OneWireAsync
+// engine returns result of the queued reading. Validity is kept per
+// sensor, temperature of a failed one is TEMP_ERROR till next pass
+// and roles without valid sensors give TEMP_ERROR.
+// Return:
+// - true - if all sensors were read
+// - false - if some sensor failed
+bool DS18B20::readAll(void)
+{
+  // sensors were read in the background
+  if (_engine)
+    return _state == STATE_READY && !_failed;
+
+  bool ok = true;
+
+  for (uint8_t i=0; i<_count; i++)
+  {
+    if (!_readScratchpad(_sensors[i].address, &_raw[i]))
+    {
+      _raw[i] = RAW_ERROR;
+      ok = false;
+    }
+  }
+
+  return ok;
+}
+
+// Return: count of sensors in the ROM table
+uint8_t DS18B20::count(void)
+{
+  return _count;
+}
+
+// Argument: role - sensor role
+// Return: count of sensors with the role
+uint8_t DS18B20::roleCount(uint8_t role)
+{
+  uint8_t devices = 0;
+
+  for (uint8_t i=0; i<_count; i++)
+  {
+    if (_sensors[i].role == role)
+      devices++;
+  }
+
+  return devices;
+}
+
+// Assign role to sensor and store the ROM table
+// Arguments: index - sensor index in the ROM table, role - new role
+void DS18B20::setRole(uint8_t index, uint8_t role)
+{
+  if (index >= _count || _sensors[index].role == role)
+    return;
+
+  _sensors[index].role = role;
+  _saveTable();
+}
+
+// Temperature of sensor from the last readAll()
+// Argument: index - sensor index in the ROM table
+// Return: temperature in degrees Celsius or TEMP_ERROR
+float DS18B20::temperature(uint8_t index)
+{
+  if (index >= _count || _raw[index] == RAW_ERROR)
+    return TEMP_ERROR;
+
+  return _raw[index] * 0.0625f;
+}
+
+// Average temperature of sensors with the role from the last readAll()
+// Argument: role - sensor role
+// Return: temperature in degrees Celsius or TEMP_ERROR
+float DS18B20::roleTemperature(uint8_t role)
+{
+  int32_t sum = 0;
+  uint8_t devices = 0;
+
+  for (uint8_t i=0; i<_count; i++)
+  {
+    if (_sensors[i].role != role || _raw[i] == RAW_ERROR)
+      continue;
+
+    sum += _raw[i];
+    devices++;
+  }
+
+  if (devices == 0)
+    return TEMP_ERROR;
+
+  return sum * 0.0625f / devices;
+}
+
 // private methods
+bool DS18B20::_reset(void)
+{
+  uint32_t beginResetTimeout = millis();
+
+  while(!_oneWire->reset())
+  {
+    uint32_t elapsedResetTimeout = millis() - beginResetTimeout;
+
+    if (elapsedResetTimeout > 1000)
+      return false;
+  }
+
+  return true;
+}
+
+// Sends command to device, or to all devices when address is NULL
 bool DS18B20::_sendCommand(uint8_t *address, uint8_t command)
 {
   if (!_oneWire->reset())
     return false;
 
-  _oneWire->select(address);
+  if (address == NULL)
+    _oneWire->skip();
+  else
+    _oneWire->select(address);
   _oneWire->write(command);
 
   return true;
@@ -238,6 +484,121 @@ bool DS18B20::_receivePowerType(uint8_t *address)
   return _oneWire->read();
 }
 
+// Reads temperature in 1/16 degrees, undefined bits of low resolution are cleared
+bool DS18B20::_readScratchpad(uint8_t *address, int16_t *raw)
+{
+  uint8_t scratchpad[9];
+
+  if (!_sendCommand(address, 0xbe))
+    return false;
+
+  _oneWire->read_bytes(scratchpad, 9);
+
+  return _parseScratchpad(scratchpad, raw);
+}
+
+bool DS18B20::_parseScratchpad(uint8_t *scratchpad, int16_t *raw)
+{
+  if (OneWire::crc8(scratchpad, 8) != scratchpad[8])
+    return false;
+
+  *raw = word(scratchpad[1], scratchpad[0]) & ~((1 << (12-_quality)) - 1);
+
+  return true;
+}
+
+// Queue reading of scratchpad of the current sensor
+bool DS18B20::_queueScratchpad(void)
+{
+  if (_index >= _count)
+    return false;
+
+  _buffer[0] = 0x55;
+  memcpy(_buffer+1, _sensors[_index].address, 8);
+  _buffer[9] = 0xbe;
+
+  return _engine->start(_buffer, 10, 9, false, _onComplete, this);
+}
+
+uint16_t DS18B20::_conversionTime(void)
+{
+  uint16_t durationTime[] = {94, 188, 375, 750};
+
+  return durationTime[_quality-9];
+}
+
+// Completion of queued transaction, called from the interrupt
+void DS18B20::_onComplete(void *context, uint8_t status)
+{
+  DS18B20 *self = (DS18B20 *)context;
+
+  if (self->_state == STATE_CONVERTING)
+  {
+    if (status == ONEWIRE_ASYNC_OK)
+      return;
+    // nothing to read
+    for (uint8_t i=0; i<self->_count; i++)
+      self->_raw[i] = RAW_ERROR;
+    self->_failed = true;
+    self->_state = STATE_READY;
+    return;
+  }
+
+  uint8_t i = self->_index;
+  if (status != ONEWIRE_ASYNC_OK || 
+      !self->_parseScratchpad(self->_buffer+10, &self->_raw[i]))
+  {
+    self->_raw[i] = RAW_ERROR;
+    self->_failed = true;
+  }
+
+  self->_index = ++i;
+  if (i >= self->_count)
+  {
+    self->_state = STATE_READY;
+    return;
+  }
+
+  if (!self->_queueScratchpad())
+  {
+    // sensors after it aren't read in this pass
+    for (; i<self->_count; i++)
+      self->_raw[i] = RAW_ERROR;
+    self->_failed = true;
+    self->_state = STATE_READY;
+  }
+}
+
+// ROM table in EEPROM: count of sensors, sensors and CRC8 of sensors
+bool DS18B20::_loadTable(void)
+{
+  uint8_t count = eeprom_read_byte((const uint8_t *)(uintptr_t)_eepromAddress);
+  uint8_t size = count * sizeof(DS18B20Sensor);
+
+  _count = 0;
+  if (count == 0 || count > DS18B20_MAX_SENSORS)
+    return false;
+
+  eeprom_read_block((void *)_sensors, (const void *)(uintptr_t)(_eepromAddress+1), size);
+
+  if (OneWire::crc8((uint8_t *)_sensors, size) != 
+      eeprom_read_byte((const uint8_t *)(uintptr_t)(_eepromAddress+1+size)))
+    return false;
+
+  _count = count;
+  return true;
+}
+
+void DS18B20::_saveTable(void)
+{
+  uint8_t size = _count * sizeof(DS18B20Sensor);
+
+  eeprom_update_byte((uint8_t *)(uintptr_t)_eepromAddress, _count);
+  eeprom_update_block((const void *)_sensors, (void *)(uintptr_t)(_eepromAddress+1), size);
+  eeprom_update_byte((uint8_t *)(uintptr_t)(_eepromAddress+1+size), 
+    OneWire::crc8((uint8_t *)_sensors, size));
+}
+
 void DS18B20::_readFlashAddress(const __FlashStringHelper *_address, uint8_t *address)
 {
   const uint8_t *pgmAddress PROGMEM = (const uint8_t PROGMEM *) _address;
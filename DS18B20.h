@@ -5,9 +5,15 @@
 #include <inttypes.h>
 #include <avr/pgmspace.h>
 #include "OneWire.h"
+#include "OneWireAsync.h"
 
 #define TEMP_ERROR -273.15f
 
+// Maximum of sensors in the cached ROM table
+#ifndef DS18B20_MAX_SENSORS
+#define DS18B20_MAX_SENSORS 4
+#endif
+
 // Pointer type to an array in flash memory of device address
 #define FA( pgm_ptr ) ( reinterpret_cast< const __FlashStringHelper * >( pgm_ptr ) )
 
@@ -20,29 +26,65 @@
 
 void __check(bool value, uint16_t line);
 
+// Entry of the ROM table, cached in EEPROM
+struct DS18B20Sensor
+{
+  uint8_t address[8];
+  uint8_t role;
+};
+
 class DS18B20
 {
 public:
-  DS18B20(OneWire *oneWire);
+  DS18B20(OneWire *oneWire, OneWireAsync *engine=NULL);
   bool begin(uint8_t quality=12);
+  bool begin(uint8_t quality, uint16_t eepromAddress, uint8_t defaultRole);
+  uint8_t discover(uint8_t defaultRole);
   bool request(void);
   bool request(uint8_t *address);
   bool request(const __FlashStringHelper *_address);
 
   bool available(void);
+  void update(void);
+  // Milliseconds till update() has work, 0xFFFF if it waits for nothing
+  uint16_t nextUpdate(void);
   float readTemperature(uint8_t *address);
   float readTemperature(const __FlashStringHelper *_address);
 
+  bool readAll(void);
+  uint8_t count(void);
+  uint8_t roleCount(uint8_t role);
+  void setRole(uint8_t index, uint8_t role);
+  float temperature(uint8_t index);
+  float roleTemperature(uint8_t role);
+
 private:
   OneWire *_oneWire;
+  OneWireAsync *_engine;
   uint8_t _quality;
   bool _samePowerType;
   bool _powerType;
   uint32_t _beginConversionTime;
+  uint16_t _eepromAddress;
+  uint8_t _count;
+  DS18B20Sensor _sensors[DS18B20_MAX_SENSORS];
+  int16_t _raw[DS18B20_MAX_SENSORS];
+  volatile uint8_t _state;
+  volatile uint8_t _index;
+  volatile bool _failed;
+  uint8_t _buffer[19];
 
+  bool _reset(void);
   bool _sendCommand(uint8_t *address, uint8_t command);
   bool _sendQuality(uint8_t *address);
   bool _receivePowerType(uint8_t *address);
+  bool _readScratchpad(uint8_t *address, int16_t *raw);
+  bool _parseScratchpad(uint8_t *scratchpad, int16_t *raw);
+  bool _queueScratchpad(void);
+  uint16_t _conversionTime(void);
+  static void _onComplete(void *context, uint8_t status);
+  bool _loadTable(void);
+  void _saveTable(void);
   void _readFlashAddress(const __FlashStringHelper *_address, uint8_t *address);
 };
 #endif
\ No newline at end of file
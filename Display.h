@@ -0,0 +1,112 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <Arduino.h>
+#include "LiquidCrystal_I2C.h"
+
+// Character grid of a display. Graphic panels like 128x64 are a grid
+// of 6x8 font cells (21x8) with 8 user defined cells.
+class Display
+{
+public:
+  uint8_t cols, rows;
+
+  Display(uint8_t _cols, uint8_t _rows) : cols(_cols), rows(_rows) {}
+
+  virtual void begin() = 0;
+  virtual void clear() = 0;
+  virtual void setCursor(uint8_t _col, uint8_t _row) = 0;
+  virtual void write(uint8_t _c) = 0;
+  virtual void createChar(uint8_t _slot, uint8_t _rows[]) = 0;
+  virtual void setBacklight(bool _on) {}
+  virtual bool isBacklight() { return true; }
+
+  void home() {
+    setCursor(0, 0);
+  }
+};
+
+// HD44780 panel over I2C, 16x2 or 20x4
+class LcdDisplay : public Display
+{
+public:
+  LcdDisplay(LiquidCrystal_I2C* _lcd, uint8_t _cols, uint8_t _rows) :
+    Display(_cols, _rows), lcd(_lcd) {}
+
+  void begin() { lcd->begin(); }
+  void clear() { lcd->clear(); }
+  void setCursor(uint8_t _col, uint8_t _row) { lcd->setCursor(_col, _row); }
+  void write(uint8_t _c) { lcd->write(_c); }
+  void createChar(uint8_t _slot, uint8_t _rows[]) { lcd->createChar(_slot, _rows); }
+  void setBacklight(bool _on) { lcd->setBacklight(_on); }
+  bool isBacklight() { return lcd->isBacklight(); }
+
+private:
+  LiquidCrystal_I2C* lcd;
+};
+
+#if !defined(__AVR__) || defined(SIMULATOR)
+// Display in memory for host builds and the simulator, custom chars are
+// shown as digits
+static const uint8_t VIRTUAL_COLS = 21;
+static const uint8_t VIRTUAL_ROWS = 8;
+
+class VirtualDisplay : public Display
+{
+public:
+  uint8_t uploads; // count of custom char uploads
+
+  VirtualDisplay(uint8_t _cols, uint8_t _rows) :
+    Display(min(_cols, VIRTUAL_COLS), min(_rows, VIRTUAL_ROWS)) {}
+
+  void begin() {
+    uploads = 0;
+    backlight = true;
+    clear();
+  }
+
+  void clear() {
+    memset(grid, ' ', sizeof(grid));
+    setCursor(0, 0);
+  }
+
+  void setCursor(uint8_t _col, uint8_t _row) {
+    col = _col;
+    row = _row;
+  }
+
+  void write(uint8_t _c) {
+    // the rest of line is outside of the screen like on HD44780
+    if(col < cols && row < rows)
+      grid[row][col] = _c < 8 ? '0'+_c : _c;
+    col++;
+  }
+
+  void createChar(uint8_t _slot, uint8_t _rows[]) {
+    uploads++;
+  }
+
+  void setBacklight(bool _on) { backlight = _on; }
+  bool isBacklight() { return backlight; }
+
+  // Line of screen for checks
+  const char* line(uint8_t _row) {
+    memcpy(text, grid[_row], cols);
+    text[cols] = '\0';
+    return text;
+  }
+
+  void print(FILE* _out) {
+    for(uint8_t r=0; r<rows; r++)
+      fprintf(_out, "|%s|\n", line(r));
+  }
+
+private:
+  char grid[VIRTUAL_ROWS][VIRTUAL_COLS];
+  char text[VIRTUAL_COLS+1];
+  uint8_t col, row;
+  bool backlight;
+};
+#endif
+
+#endif // __DISPLAY_H__
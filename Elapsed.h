@@ -0,0 +1,23 @@
+#ifndef Elapsed_h
+#define Elapsed_h
+
+// Rollover-safe checks of millis() or seconds() timestamps. They hold
+// across rollover while timestamps are less than 2^32 apart, unlike
+// comparisons of since+interval with now.
+
+// Interval has passed since timestamp
+inline bool elapsed(unsigned long now, unsigned long since,
+  unsigned long interval)
+{
+  return now - since >= interval;
+}
+
+// Time left of interval since timestamp, 0 if it has passed
+inline unsigned long remaining(unsigned long now, unsigned long since,
+  unsigned long interval)
+{
+  unsigned long passed = now - since;
+  return passed < interval ? interval - passed : 0;
+}
+
+#endif
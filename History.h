@@ -0,0 +1,162 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+//#define DEBUG_HISTORY
+
+// Minutes in the raw tier, one quarter of hour
+static const uint8_t HISTORY_MINUTES = 15;
+// Quarters in an hour
+static const uint8_t HISTORY_QUARTERS = 4;
+// Hours in the hourly tier
+static const uint8_t HISTORY_HOURS = 16;
+
+template<typename T>
+struct Aggregate {
+  T min, max, avg;
+};
+
+// Fixed memory history of sensor in three tiers: raw values for every
+// minute, aggregates of 15 minutes and of hours. Aggregates are
+// accumulated on the fly, so update is O(1). The last quarter and hour
+// are kept exactly, ranges of older hours are a ring of 8-bit fixed point
+// values, value >> SHIFT, for the graph.
+// S is type of sums, it should keep 15 values of T.
+template<typename T, typename S = uint16_t, uint8_t SHIFT = 0>
+class History
+{
+public:
+  History() : lastQuarter(), lastHour(), quarterSum(0), hourSum(0),
+    minuteHead(0), minuteCount(0), quarterMinutes(0), hourQuarters(0),
+    hourHead(0), hourCount(0), dayStarted(false) {}
+
+  // Add value, call it every minute
+  void update(T _value) {
+    minutes[minuteHead] = _value;
+    if(++minuteHead >= HISTORY_MINUTES)
+      minuteHead = 0;
+    if(minuteCount < HISTORY_MINUTES)
+      minuteCount++;
+    // daily extremes
+    if(dayStarted == false || _value < dayMin)
+      dayMin = _value;
+    if(dayStarted == false || _value > dayMax)
+      dayMax = _value;
+    dayStarted = true;
+    // accumulate quarter
+    if(quarterMinutes == 0 || _value < quarterRun.min)
+      quarterRun.min = _value;
+    if(quarterMinutes == 0 || _value > quarterRun.max)
+      quarterRun.max = _value;
+    quarterSum += _value;
+    if(++quarterMinutes < HISTORY_MINUTES)
+      return;
+    quarterRun.avg = quarterSum / HISTORY_MINUTES;
+    lastQuarter = quarterRun;
+    quarterMinutes = 0;
+    quarterSum = 0;
+    // accumulate hour
+    if(hourQuarters == 0 || quarterRun.min < hourRun.min)
+      hourRun.min = quarterRun.min;
+    if(hourQuarters == 0 || quarterRun.max > hourRun.max)
+      hourRun.max = quarterRun.max;
+    hourSum += quarterRun.avg;
+    if(++hourQuarters < HISTORY_QUARTERS)
+      return;
+    hourRun.avg = hourSum / HISTORY_QUARTERS;
+    lastHour = hourRun;
+    // range is rounded outwards
+    hourMins[hourHead] = hourRun.min >> SHIFT;
+    uint16_t max = ((uint32_t)hourRun.max + (1 << SHIFT) - 1) >> SHIFT;
+    hourMaxs[hourHead] = max > 0xFF ? 0xFF : max;
+    if(++hourHead >= HISTORY_HOURS)
+      hourHead = 0;
+    if(hourCount < HISTORY_HOURS)
+      hourCount++;
+    hourQuarters = 0;
+    hourSum = 0;
+  }
+
+  // Reset daily extremes, call it at midnight
+  void startDay() {
+    yesterdayMin = dayMin;
+    yesterdayMax = dayMax;
+    dayStarted = false;
+  }
+
+  // Last value
+  T last() {
+    return minute(0);
+  }
+
+  // Value of minute ago, 0 is the last one
+  T minute(uint8_t _ago) {
+    return minutes[index(minuteHead, _ago, HISTORY_MINUTES)];
+  }
+
+  // Aggregate of the last completed quarter
+  Aggregate<T> quarter() {
+    return lastQuarter;
+  }
+
+  // Aggregate of the last completed hour
+  Aggregate<T> hour() {
+    return lastHour;
+  }
+
+  // Range of hour ago, 0 is the last completed one, in steps of
+  // 1 << SHIFT
+  T hourMin(uint8_t _ago) {
+    return (T)hourMins[index(hourHead, _ago, HISTORY_HOURS)] << SHIFT;
+  }
+  T hourMax(uint8_t _ago) {
+    return (T)hourMaxs[index(hourHead, _ago, HISTORY_HOURS)] << SHIFT;
+  }
+
+  // Count of completed hours
+  uint8_t hoursCount() {
+    return hourCount;
+  }
+
+  // Direction of changes for the raw tier: 1 up, -1 down, 0 stable
+  int8_t trend() {
+    if(minuteCount < 2)
+      return 0;
+    T oldest = minute(minuteCount-1);
+    T newest = minute(0);
+    if(newest > oldest)
+      return 1;
+    if(newest < oldest)
+      return -1;
+    return 0;
+  }
+
+  // Changes per hour for the raw tier
+  int16_t rate() {
+    if(minuteCount < 2)
+      return 0;
+    int32_t diff = (int32_t)minute(0) - minute(minuteCount-1);
+    return diff*60 / (minuteCount-1);
+  }
+
+  T todayMin() { return dayMin; }
+  T todayMax() { return dayMax; }
+  T lastDayMin() { return yesterdayMin; }
+  T lastDayMax() { return yesterdayMax; }
+
+private:
+  T minutes[HISTORY_MINUTES];
+  uint8_t hourMins[HISTORY_HOURS], hourMaxs[HISTORY_HOURS];
+  Aggregate<T> quarterRun, hourRun, lastQuarter, lastHour;
+  S quarterSum, hourSum;
+  T dayMin, dayMax, yesterdayMin, yesterdayMax;
+  uint8_t minuteHead, minuteCount, quarterMinutes;
+  uint8_t hourQuarters, hourHead, hourCount;
+  bool dayStarted;
+
+  // Index of item ago from the ring head
+  static uint8_t index(uint8_t _head, uint8_t _ago, uint8_t _size) {
+    return _head > _ago ? _head-_ago-1 : _size+_head-_ago-1;
+  }
+};
+
+#endif // __HISTORY_H__
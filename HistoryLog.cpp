@@ -0,0 +1,330 @@
+#include "HistoryLog.h"
+
+// EEPROM backend
+
+EepromLogStorage::EepromLogStorage(uint16_t offset, uint16_t size)
+{
+  _offset = offset;
+  _size = size;
+}
+
+uint16_t EepromLogStorage::size(void)
+{
+  return _size;
+}
+
+void EepromLogStorage::read(uint16_t address, uint8_t *buffer, uint8_t length)
+{
+  eeprom_read_block((void *)buffer, (const void *)(uintptr_t)(_offset+address), length);
+}
+
+void EepromLogStorage::write(uint16_t address, const uint8_t *buffer, uint8_t length)
+{
+  // only changed bytes are written
+  eeprom_update_block((const void *)buffer, (void *)(uintptr_t)(_offset+address), length);
+}
+
+// DS1307 NVRAM backend
+
+NvramLogStorage::NvramLogStorage(RTC_DS1307 *rtc)
+{
+  _rtc = rtc;
+}
+
+uint16_t NvramLogStorage::size(void)
+{
+  return 56;
+}
+
+void NvramLogStorage::read(uint16_t address, uint8_t *buffer, uint8_t length)
+{
+  // keep transactions inside of Wire buffer
+  while (length > 0) {
+    uint8_t chunk = min(length, 16);
+    _rtc->readnvram(buffer, chunk, address);
+    address += chunk;
+    buffer += chunk;
+    length -= chunk;
+  }
+}
+
+void NvramLogStorage::write(uint16_t address, const uint8_t *buffer, uint8_t length)
+{
+  while (length > 0) {
+    uint8_t chunk = min(length, 16);
+    _rtc->writenvram(address, (uint8_t *)buffer, chunk);
+    address += chunk;
+    buffer += chunk;
+    length -= chunk;
+  }
+}
+
+#if !defined(__AVR__) || defined(SIMULATOR)
+// File backend, erased file is filled by 0xFF like flash
+
+FileLogStorage::FileLogStorage(const char *path, uint16_t size)
+{
+  _size = size;
+  _file = fopen(path, "r+b");
+  if (_file == NULL) {
+    _file = fopen(path, "w+b");
+    for (uint16_t i = 0; _file && i < size; i++)
+      fputc(0xFF, _file);
+  }
+}
+
+FileLogStorage::~FileLogStorage()
+{
+  if (_file)
+    fclose(_file);
+}
+
+uint16_t FileLogStorage::size(void)
+{
+  return _size;
+}
+
+void FileLogStorage::read(uint16_t address, uint8_t *buffer, uint8_t length)
+{
+  memset(buffer, 0xFF, length);
+  if (_file && fseek(_file, address, SEEK_SET) == 0)
+    fread(buffer, 1, length, _file);
+}
+
+void FileLogStorage::write(uint16_t address, const uint8_t *buffer, uint8_t length)
+{
+  uint8_t current[LOG_MAX_BLOCK];
+  read(address, current, length);
+  // flash can only clear bits
+  for (uint8_t i = 0; i < length; i++)
+    current[i] &= buffer[i];
+  if (_file && fseek(_file, address, SEEK_SET) == 0) {
+    fwrite(current, 1, length, _file);
+    fflush(_file);
+  }
+}
+
+void FileLogStorage::erase(uint16_t address, uint8_t length)
+{
+  uint8_t erased[LOG_MAX_BLOCK];
+  memset(erased, 0xFF, length);
+  if (_file && fseek(_file, address, SEEK_SET) == 0) {
+    fwrite(erased, 1, length, _file);
+    fflush(_file);
+  }
+}
+#endif
+
+// Log
+
+HistoryLog::HistoryLog(LogStorage *storage, uint8_t blockSize, uint16_t interval,
+  uint8_t series)
+{
+  _storage = storage;
+  _blockSize = min(blockSize, LOG_MAX_BLOCK);
+  _blockCount = min(storage->size() / _blockSize, 255);
+  _interval = interval;
+  _series = min(series, LOG_SERIES);
+  _block = _blockCount - 1;
+  _sequence = 0xFF;
+  _open = false;
+  rawBytes = 0;
+  encodedBytes = 0;
+}
+
+void HistoryLog::begin(void)
+{
+  uint8_t sequence, next;
+  uint32_t time;
+  uint8_t count;
+
+  _open = false;
+  for (uint8_t i = 0; i < _blockCount; i++) {
+    if (!_readHeader(i, &sequence, &time, &count))
+      continue;
+    // the newest block isn't followed by the next sequence
+    uint8_t following = i+1 < _blockCount ? i+1 : 0;
+    if (_readHeader(following, &next, &time, &count) && next == (uint8_t)(sequence+1))
+      continue;
+    _block = i;
+    _sequence = sequence;
+    return;
+  }
+}
+
+bool HistoryLog::append(uint32_t time, const uint16_t *values)
+{
+  uint8_t record[LOG_SERIES*5];
+#ifdef DEBUG_LOG
+  unsigned long start = micros();
+#endif
+
+  if (_blockCount == 0)
+    return false;
+
+  // gap in records or full block
+  if (!_open || time != _lastTime + _interval || _count >= LOG_MAX_RECORDS)
+    _startBlock(time);
+
+  uint8_t length = _encodeRecord(values, record);
+  if (LOG_HEADER_SIZE + _length + length > _blockSize) {
+    _startBlock(time);
+    length = _encodeRecord(values, record);
+  }
+
+  uint16_t address = (uint16_t)_block * _blockSize;
+  _storage->write(address + LOG_HEADER_SIZE + _length, record, length);
+  _length += length;
+  _count++;
+  // clear one bit of the counter per record
+  uint16_t counter = (uint16_t)(0xFFFFUL << _count);
+  uint8_t bits[2] = {(uint8_t)counter, (uint8_t)(counter >> 8)};
+  _storage->write(address + 6, bits, 2);
+
+  // commit encoder state
+  for (uint8_t i = 0; i < _series; i++) {
+    if (_count > 1)
+      _delta[i] = (int32_t)values[i] - _previous[i];
+    _previous[i] = values[i];
+  }
+  _lastTime = time;
+
+  rawBytes += _series * sizeof(uint16_t);
+  encodedBytes += length;
+#ifdef DEBUG_LOG
+  printf_P(PSTR("LOG: Info: Record %d bytes in %u us, block %d, ratio %d%%.\n\r"),
+    length, (unsigned int)(micros()-start), _block, 
+    (int)(encodedBytes*100/rawBytes));
+#endif
+  return true;
+}
+
+uint8_t HistoryLog::blocks(void)
+{
+  return _blockCount;
+}
+
+uint8_t HistoryLog::series(void)
+{
+  return _series;
+}
+
+uint8_t HistoryLog::read(uint8_t ago, uint32_t *time, uint16_t *values, uint8_t maxRecords)
+{
+  uint8_t sequence, count;
+  uint8_t buffer[LOG_MAX_BLOCK];
+
+  if (ago >= _blockCount)
+    return 0;
+  uint8_t block = _block >= ago ? _block - ago : _blockCount + _block - ago;
+  if (!_readHeader(block, &sequence, time, &count) || 
+      sequence != (uint8_t)(_sequence - ago))
+    return 0;
+
+  uint8_t length = _blockSize - LOG_HEADER_SIZE;
+  _storage->read((uint16_t)block * _blockSize + LOG_HEADER_SIZE, buffer, length);
+
+  int32_t previous[LOG_SERIES], delta[LOG_SERIES];
+  uint8_t position = 0;
+  count = min(count, maxRecords);
+  for (uint8_t r = 0; r < count; r++) {
+    for (uint8_t i = 0; i < _series; i++) {
+      int32_t value;
+      uint8_t used = _readVarint(buffer + position, length - position, &value);
+      if (used == 0)
+        return r;
+      position += used;
+      if (r == 1) {
+        delta[i] = value;
+        value += previous[i];
+      } else if (r > 1) {
+        delta[i] += value;
+        value = previous[i] + delta[i];
+      }
+      previous[i] = value;
+      values[r*_series + i] = value;
+    }
+  }
+  return count;
+}
+
+void HistoryLog::_startBlock(uint32_t time)
+{
+  if (++_block >= _blockCount)
+    _block = 0;
+  _sequence++;
+
+  uint16_t address = (uint16_t)_block * _blockSize;
+  _storage->erase(address, _blockSize);
+  uint8_t header[LOG_HEADER_SIZE] = {
+    LOG_MAGIC, _sequence, 
+    (uint8_t)time, (uint8_t)(time >> 8), (uint8_t)(time >> 16), (uint8_t)(time >> 24),
+    0xFF, 0xFF
+  };
+  _storage->write(address, header, LOG_HEADER_SIZE);
+
+  _count = 0;
+  _length = 0;
+  _open = true;
+}
+
+uint8_t HistoryLog::_encodeRecord(const uint16_t *values, uint8_t *buffer)
+{
+  uint8_t length = 0;
+
+  for (uint8_t i = 0; i < _series; i++) {
+    int32_t value = values[i];
+    if (_count == 1)
+      value -= _previous[i];
+    else if (_count > 1)
+      value -= _previous[i] + _delta[i];
+    length += _writeVarint(value, buffer + length);
+  }
+  return length;
+}
+
+bool HistoryLog::_readHeader(uint8_t block, uint8_t *sequence, uint32_t *time, uint8_t *count)
+{
+  uint8_t header[LOG_HEADER_SIZE];
+
+  _storage->read((uint16_t)block * _blockSize, header, LOG_HEADER_SIZE);
+  if (header[0] != LOG_MAGIC)
+    return false;
+
+  *sequence = header[1];
+  *time = header[2] | (uint32_t)header[3] << 8 | 
+    (uint32_t)header[4] << 16 | (uint32_t)header[5] << 24;
+  uint16_t counter = header[6] | header[7] << 8;
+  for (*count = 0; *count < LOG_MAX_RECORDS && !(counter & 1); (*count)++)
+    counter >>= 1;
+  return true;
+}
+
+// Zigzag maps small negative values to small positive ones,
+// varint stores 7 bits per byte while the high bit is set
+uint8_t HistoryLog::_writeVarint(int32_t value, uint8_t *buffer)
+{
+  uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+  uint8_t length = 0;
+
+  while (zigzag >= 0x80) {
+    buffer[length++] = (uint8_t)zigzag | 0x80;
+    zigzag >>= 7;
+  }
+  buffer[length++] = (uint8_t)zigzag;
+  return length;
+}
+
+uint8_t HistoryLog::_readVarint(const uint8_t *buffer, uint8_t length, int32_t *value)
+{
+  uint32_t zigzag = 0;
+
+  for (uint8_t i = 0; i < length && i < 5; i++) {
+    zigzag |= (uint32_t)(buffer[i] & 0x7F) << (7*i);
+    if (!(buffer[i] & 0x80)) {
+      *value = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+      return i+1;
+    }
+  }
+  return 0;
+}
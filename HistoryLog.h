@@ -0,0 +1,134 @@
+#ifndef HistoryLog_h
+#define HistoryLog_h
+
+#include <Arduino.h>
+#include <avr/eeprom.h>
+#include "RTClib.h"
+
+//#define DEBUG_LOG
+
+// Maximum of series in every record
+#ifndef LOG_SERIES
+#define LOG_SERIES 6
+#endif
+
+// Block header: magic, sequence, time of the first record (4 bytes)
+// and unary counter of records (2 bytes)
+#define LOG_HEADER_SIZE 8
+#define LOG_MAGIC 0xA5
+// Maximum of records in block, one bit of the counter per record
+#define LOG_MAX_RECORDS 16
+// Maximum size of block
+#define LOG_MAX_BLOCK 64
+
+// Storage backend of the log. Every block is erased before it is
+// written, after that bits are only cleared, so flash memory fits too.
+class LogStorage
+{
+  public:
+    virtual uint16_t size(void) = 0;
+    virtual void read(uint16_t address, uint8_t *buffer, uint8_t length) = 0;
+    virtual void write(uint16_t address, const uint8_t *buffer, uint8_t length) = 0;
+    virtual void erase(uint16_t address, uint8_t length) {}
+};
+
+// Spare EEPROM area
+class EepromLogStorage : public LogStorage
+{
+  public:
+    EepromLogStorage(uint16_t offset, uint16_t size);
+    uint16_t size(void);
+    void read(uint16_t address, uint8_t *buffer, uint8_t length);
+    void write(uint16_t address, const uint8_t *buffer, uint8_t length);
+
+  private:
+    uint16_t _offset;
+    uint16_t _size;
+};
+
+// 56 bytes of DS1307 battery backed RAM
+class NvramLogStorage : public LogStorage
+{
+  public:
+    NvramLogStorage(RTC_DS1307 *rtc);
+    uint16_t size(void);
+    void read(uint16_t address, uint8_t *buffer, uint8_t length);
+    void write(uint16_t address, const uint8_t *buffer, uint8_t length);
+
+  private:
+    RTC_DS1307 *_rtc;
+};
+
+#if !defined(__AVR__) || defined(SIMULATOR)
+// File as stand-in of SPI flash for the host and the simulator
+class FileLogStorage : public LogStorage
+{
+  public:
+    FileLogStorage(const char *path, uint16_t size);
+    ~FileLogStorage();
+    uint16_t size(void);
+    void read(uint16_t address, uint8_t *buffer, uint8_t length);
+    void write(uint16_t address, const uint8_t *buffer, uint8_t length);
+    void erase(uint16_t address, uint8_t length);
+
+  private:
+    FILE *_file;
+    uint16_t _size;
+};
+#endif
+
+// Append-only circular log of periodic records. Every block starts with
+// absolute values, then first deltas, then deltas of deltas, all zigzag
+// varint encoded, so slow series take about one byte per value.
+// Blocks are decoded independently for random access.
+class HistoryLog
+{
+  public:
+    HistoryLog(LogStorage *storage, uint8_t blockSize, uint16_t interval,
+      uint8_t series = LOG_SERIES);
+
+    // Find the newest block, next record starts a new block
+    void begin(void);
+
+    // Append record of series values, time in seconds.
+    // A new block is started when the record doesn't follow the previous
+    // one by interval.
+    bool append(uint32_t time, const uint16_t *values);
+
+    // Count of blocks in the storage
+    uint8_t blocks(void);
+
+    // Count of values in every record
+    uint8_t series(void);
+
+    // Decode block ago (0 is the newest) into values[records][series].
+    // Returns count of records, time is the time of the first record.
+    uint8_t read(uint8_t ago, uint32_t *time, uint16_t *values, uint8_t maxRecords);
+
+    // Statistics of compression
+    uint32_t rawBytes;
+    uint32_t encodedBytes;
+
+  private:
+    LogStorage *_storage;
+    uint8_t _blockSize;
+    uint8_t _blockCount;
+    uint16_t _interval;
+    uint8_t _series;
+    uint8_t _block;
+    uint8_t _sequence;
+    uint8_t _count;
+    uint8_t _length;
+    bool _open;
+    uint32_t _lastTime;
+    int32_t _previous[LOG_SERIES];
+    int32_t _delta[LOG_SERIES];
+
+    void _startBlock(uint32_t time);
+    uint8_t _encodeRecord(const uint16_t *values, uint8_t *buffer);
+    bool _readHeader(uint8_t block, uint8_t *sequence, uint32_t *time, uint8_t *count);
+    static uint8_t _writeVarint(int32_t value, uint8_t *buffer);
+    static uint8_t _readVarint(const uint8_t *buffer, uint8_t length, int32_t *value);
+};
+
+#endif
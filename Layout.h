@@ -0,0 +1,82 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <avr/pgmspace.h>
+
+static const uint8_t LAYOUT_MAX_WIDGETS = 8;
+static const uint8_t LAYOUT_MAX_ROWS = 8;
+static const uint8_t LAYOUT_HIDDEN = 0xFF;
+
+// Places widgets on a character grid by priority. Widgets go to the
+// first row with enough free columns, one column apart, the ones that
+// don't fit move to the next page. First 'sticky' widgets are shown on every page, so a
+// small panel rotates pages and a big one shows everything at once.
+class Layout
+{
+public:
+  uint8_t count;
+  uint8_t pages;
+  uint8_t page[LAYOUT_MAX_WIDGETS];
+  uint8_t row[LAYOUT_MAX_WIDGETS];
+  uint8_t col[LAYOUT_MAX_WIDGETS];
+
+  // Widths are in flash in order of priority
+  void arrange(const uint8_t* _widths, uint8_t _count, uint8_t _sticky,
+      uint8_t _cols, uint8_t _rows) {
+    uint8_t used[LAYOUT_MAX_ROWS], stickyUsed[LAYOUT_MAX_ROWS];
+    count = min(_count, LAYOUT_MAX_WIDGETS);
+    sticky = _sticky;
+    _rows = min(_rows, LAYOUT_MAX_ROWS);
+    memset(stickyUsed, 0, sizeof(stickyUsed));
+    memset(page, LAYOUT_HIDDEN, sizeof(page));
+    for(uint8_t w=0; w<_sticky && w<count; w++)
+      place(w, pgm_read_byte(&_widths[w]), 0, stickyUsed, _cols, _rows);
+    uint8_t left = count - min(_sticky, count);
+    for(pages = 0; left > 0; pages++) {
+      memcpy(used, stickyUsed, sizeof(used));
+      uint8_t placed = 0;
+      for(uint8_t w=_sticky; w<count; w++) {
+        if(page[w] != LAYOUT_HIDDEN)
+          continue;
+        if(place(w, pgm_read_byte(&_widths[w]), pages, used, _cols, _rows))
+          placed++;
+      }
+      if(placed == 0)
+        // the rest is too wide for the screen
+        break;
+      left -= placed;
+    }
+    if(pages == 0)
+      pages = 1;
+  }
+
+  bool visible(uint8_t _widget, uint8_t _page) {
+    return page[_widget] == _page ||
+      (page[_widget] != LAYOUT_HIDDEN && isSticky(_widget));
+  }
+
+private:
+  uint8_t sticky;
+
+  bool isSticky(uint8_t _widget) {
+    return _widget < sticky;
+  }
+
+  bool place(uint8_t _widget, uint8_t _width, uint8_t _page,
+      uint8_t* _used, uint8_t _cols, uint8_t _rows) {
+    for(uint8_t r=0; r<_rows; r++) {
+      // separator column after the previous widget of row
+      uint8_t start = _used[r] > 0 ? _used[r] + 1 : 0;
+      if(start + _width > _cols)
+        continue;
+      page[_widget] = _page;
+      row[_widget] = r;
+      col[_widget] = start;
+      _used[r] = start + _width;
+      return true;
+    }
+    return false;
+  }
+};
+
+#endif // __LAYOUT_H__
@@ -0,0 +1,125 @@
+#ifndef LCDFORMAT_H
+#define LCDFORMAT_H
+
+#include <avr/pgmspace.h>
+#include "Display.h"
+
+// Fixed-width field writer for display screens. It replaces fprintf_P
+// (vfprintf with its format parser and stack frame) by direct field
+// renderers. Blink regions are opened and closed by blinkBegin() and
+// blinkEnd(), '{' and '}' in flash text do the same.
+class LcdFormat
+{
+public:
+  bool textBlink; // enable blinking
+  uint8_t blinkPos; // number of blinking region, false for all
+  uint8_t column; // characters written to current line
+
+  LcdFormat(Display* _display) : textBlink(false), blinkPos(false),
+    column(0), display(_display), row(0), charErase(false),
+    textErase(false), blinkCursor(0) {}
+
+  void home() {
+    moveTo(0, 0);
+  }
+
+  void newline() {
+    moveTo(0, row+1);
+  }
+
+  void moveTo(uint8_t _column, uint8_t _row) {
+    display->setCursor(_column, _row);
+    column = _column;
+    row = _row;
+    blinkCursor = 0;
+  }
+
+  void text(char _c) {
+    display->write(charErase ? ' ' : _c);
+    column++;
+  }
+
+  // Flash string, '\n' moves to the next line
+  void text_P(const char* _text) {
+    char c;
+    while((c = pgm_read_byte(_text++)) != '\0') {
+      switch(c) {
+        case '\n':
+          newline();
+          break;
+        case '{':
+          blinkBegin();
+          break;
+        case '}':
+          blinkEnd();
+          break;
+        default:
+          text(c);
+      }
+    }
+  }
+
+  // Right aligned unsigned number, longer numbers aren't cut
+  void number(uint16_t _value, uint8_t _width, char _pad = ' ') {
+    static const uint16_t powers[] PROGMEM = {10000, 1000, 100, 10, 1};
+    bool leading = true;
+    for(uint8_t i=0; i<5; i++) {
+      uint16_t power = pgm_read_word(&powers[i]);
+      // digit by subtraction, AVR has no divider
+      char digit = '0';
+      while(_value >= power) {
+        _value -= power;
+        digit++;
+      }
+      if(leading && digit == '0' && power != 1) {
+        if(5-i <= _width)
+          text(_pad);
+        continue;
+      }
+      leading = false;
+      text(digit);
+    }
+  }
+
+  // Number in blinking region
+  void field(uint16_t _value, uint8_t _width, char _pad = ' ') {
+    blinkBegin();
+    number(_value, _width, _pad);
+    blinkEnd();
+  }
+
+  // hh:mm
+  void time(uint8_t _hour, uint8_t _minute) {
+    number(_hour, 2, '0');
+    text(':');
+    number(_minute, 2, '0');
+  }
+
+  void blinkBegin() {
+    blinkCursor++;
+    if(textBlink && textErase &&
+        (blinkPos == false || blinkPos == blinkCursor))
+      charErase = true;
+  }
+
+  void blinkEnd() {
+    if(blinkPos == false || blinkPos == blinkCursor) {
+      charErase = false;
+      textErase = !textErase;
+    }
+  }
+
+  // Erase line up to column
+  void clear(uint8_t _columns) {
+    while(column < _columns)
+      text(' ');
+  }
+
+private:
+  Display* display;
+  uint8_t row;
+  bool charErase, textErase;
+  uint8_t blinkCursor;
+};
+
+#endif // __LCDFORMAT_H__
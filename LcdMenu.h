@@ -1,56 +1,63 @@
 #ifndef LCDMENU_H
 #define LCDMENU_H
 
+#include <stddef.h>
 #include "LiquidCrystal_I2C.h"
-#include "SimpleMap.h"
+#include "Display.h"
+#include "LcdFormat.h"
+#include "Layout.h"
 #include "Settings.h"
+#include "CropCalendar.h"
 #include "RTClib.h"
+#include "History.h"
 #include "Beep.h"
-
-// Declare LCD
-LiquidCrystal_I2C lcd(0x27, 16, 2);
+#include "States.h"
+#include "Uptime.h"
+
+//#define DEBUG_LCD
+
+// Display size, 20x4 panel shows the home screen without rotation
+#ifndef LCD_COLS
+#define LCD_COLS 16
+#define LCD_ROWS 2
+#endif
+
+// Declare LCD, host tests draw screens in memory
+#ifdef LCD_VIRTUAL
+VirtualDisplay display(LCD_COLS, LCD_ROWS);
+#else
+LiquidCrystal_I2C lcd(0x27, LCD_COLS, LCD_ROWS);
+LcdDisplay display(&lcd, LCD_COLS, LCD_ROWS);
+#endif
 // Declare lcd output
-FILE lcd_out = {0};
-static bool charErase, textErase, textBlink;
-static uint8_t blinkCursor, blinkPos;
-static int lcd_putchar(char c, FILE *) {
-  switch(c) {
-    case '\n':
-      lcd.setCursor(0,1);
-      blinkCursor = 0;
-      break;
-    case '{':
-      blinkCursor++;
-      if(textBlink && textErase && 
-          (blinkPos == false || blinkPos == blinkCursor))
-        charErase = true;
-      break;
-    case '}':
-      if(blinkPos == false || blinkPos == blinkCursor) {
-        charErase = false;
-        textErase = !textErase;
-      }
-      break;
-    default:
-      if(charErase)
-        c = ' ';
-      lcd.write(c);
-  }
-  return 0;
-};
+LcdFormat out(&display);
+// Declare home screen layout
+Layout layout;
 
 // Declare Speaker digital pin
 Beep beep(8);
 
 // Declare settings
 EEPROM storage;
+// Declare grow profiles and calendar over settings
+Profiles profiles(settings);
+CropCalendar calendar(settings, profiles);
 
 // Declare RTC
 RTC_DS1307 rtc;
 DateTime clock;
 
+// Declare tanks level
+TankLevel substrateTank, waterTank;
+
+// Declare sensors history
+History<uint8_t> airTempHistory, humidityHistory; 
+History<uint8_t> substrateTempHistory, computerTempHistory;
+// graph of light is in steps of 256 lux
+History<uint16_t, uint32_t, 8> lightHistory;
+
 // Declare state map
-SimpleMap<uint8_t, uint16_t, 17> states;
+States states;
 
 // Define custom LCD characters
 static const uint8_t C_CELCIUM = 0;
@@ -73,52 +80,102 @@ static const uint8_t HUMIDITY_RANGE = 7;
 static const uint8_t AIR_TEMP_RANGE = 8;
 static const uint8_t SUBSTRATE_TEMP_MINIMUM = 9;
 static const uint8_t SILENT_NIGHT = 10;
-static const uint8_t EMERGENCE = 11;
+static const uint8_t PROFILE = 11;
 static const uint8_t CLOCK = 12;
-// Define warning states
-static const uint8_t NO_WARNING = 0;
-static const uint8_t INFO_SUBSTRATE_FULL = 1;
-static const uint8_t WARNING_SUBSTRATE_LOW = 2;
-static const uint8_t INFO_SUBSTRATE_DELIVERED = 3;
-static const uint8_t WARNING_WATERING = 4;
-static const uint8_t WARNING_MISTING = 5;
-static const uint8_t WARNING_AIR_COLD = 6;
-static const uint8_t WARNING_AIR_HOT = 7;
-static const uint8_t WARNING_SUBSTRATE_COLD = 8;
-static const uint8_t WARNING_NO_WATER = 9;
-// Define error states
-static const uint8_t NO_ERROR = 0;
-static const uint8_t ERROR_LOW_MEMORY = 10;
-static const uint8_t ERROR_EEPROM = 11;
-static const uint8_t ERROR_DHT = 12;
-static const uint8_t ERROR_BH1750 = 13;
-static const uint8_t ERROR_DS18B20 = 14;
-static const uint8_t ERROR_NO_SUBSTRATE = 15;
-static const uint8_t ERROR_CLOCK = 16;
-// Define state map keys constants
-static const uint8_t HUMIDITY = 1; // air humidity
-static const uint8_t AIR_TEMP = 2;
-static const uint8_t COMPUTER_TEMP = 3; // temperature inside
-static const uint8_t SUBSTRATE_TEMP = 4;
-static const uint8_t LIGHT = 5; // light intensivity
-static const uint8_t PUMP_MISTING = 6;
-static const uint8_t PUMP_WATERING = 7;
-static const uint8_t LAMP = 8;
-static const uint8_t WARNING = 9;
-static const uint8_t ERROR = 10;
-static const uint8_t PREV_HUMIDITY = 11;
-static const uint8_t PREV_AIR_TEMP = 12;
-static const uint8_t PREV_COMPUTER_TEMP = 13;
-static const uint8_t PREV_SUBSTRATE_TEMP = 14;
-static const uint8_t PREV_LIGHT = 15;
-static const uint8_t WATERING = 16;
-static const uint8_t MISTING = 17;
+static const uint8_t GRAPH = 13;
+static const uint8_t ZONE = 14;
+static const uint8_t WARNING_SCREEN = 0xF0;
+static const uint8_t ALERT_SCREEN = 0xF1;
+// Declare alarm set
+Alarms alarms(LATCHING_ALARMS);
 // Define constants
 static const uint8_t ENHANCED_MODE = 2; // edit mode
 static const bool ONE_BLINK = 1;
 static const uint16_t ONE_SEC = 1000;
 static const uint16_t HALF_MIN = 30*ONE_SEC;
 static const uint16_t ONE_MIN = 60*ONE_SEC;
+// Define sparkline graph constants
+static const uint8_t GRAPH_COLUMNS = 16; // one column per hour
+static const uint8_t GLYPH_SLOTS = 8; // CGRAM size
+static const uint8_t GLYPH_ICON = 0xFF; // slot keeps custom character
+static const uint8_t GLYPH_EMPTY = 0xFE; // no data
+static const uint8_t GLYPH_FULL = 7; // range 0-7 is ROM block
+static const char LCD_BLOCK = 0xFF;
+
+// Define settings field flags
+static const uint8_t FIELD_WORD = 1; // uint16_t value
+static const uint8_t FIELD_WRAP = 2; // wrap around range instead of stop
+static const uint8_t FIELD_ZERO_OFF = 4; // zero is shown as disabled
+static const uint8_t FIELD_TIME = 8; // minutes shown as hh:mm
+static const uint8_t FIELD_CELCIUM = 16; // degree char after value
+static const uint8_t FIELD_ZONE = 32; // field of selected zone
+static const uint8_t MENU_FIELDS = 2;
+
+// Editable field of settings
+struct MenuField {
+  uint8_t offset; // in SettingsStruct
+  uint8_t flags;
+  uint8_t width;
+  uint8_t step;
+  uint16_t minimum, maximum;
+  char prefix[9], suffix[9];
+};
+
+// Settings screen, fields are edited one by one
+struct MenuItem {
+  char title[17];
+  uint8_t count;
+  MenuField fields[MENU_FIELDS];
+};
+
+#define FIELD(name) offsetof(SettingsStruct, name)
+#define ZONE_FIELD(name) offsetof(SettingsStruct, zones[0].name)
+
+// Settings screens in order of menu items from WATERING_DURATION
+static const MenuItem menuItems[] PROGMEM = {
+  {"Watering durat. ", 1, {
+    {ZONE_FIELD(wateringDuration), FIELD_ZONE, 2, 1, 1, 99, "for ", " min"}}},
+  {"Watering period ", 2, {
+    {ZONE_FIELD(wateringSunnyPeriod), FIELD_ZONE|FIELD_ZERO_OFF, 3, 1, 0, 255, "sun ", "/"},
+    {ZONE_FIELD(wateringPeriod), FIELD_ZONE|FIELD_ZERO_OFF, 3, 1, 0, 255, "", " min"}}},
+  {"Misting duration", 1, {
+    {ZONE_FIELD(mistingDuration), FIELD_ZONE, 2, 1, 1, 99, "for ", " sec"}}},
+  {"Misting period  ", 2, {
+    {ZONE_FIELD(mistingSunnyPeriod), FIELD_ZONE|FIELD_ZERO_OFF, 3, 1, 0, 255, "sun ", "/"},
+    {ZONE_FIELD(mistingPeriod), FIELD_ZONE|FIELD_ZERO_OFF, 3, 1, 0, 255, "", " min"}}},
+  {"Light day       ", 2, {
+    {FIELD(lightDayDuration), 0, 2, 1, 1, 24, "", "h"},
+    {FIELD(lightMinimum), FIELD_WORD, 4, 100, 0, 9900, " with ", "lux"}}},
+  {"Light day from  ", 1, {
+    {FIELD(lightDayStart), FIELD_WORD|FIELD_TIME|FIELD_WRAP, 5, 60, 0, 23*60, 
+      "", " o'clock"}}},
+  {"Humidity range  ", 2, {
+    {FIELD(humidMinimum), 0, 2, 1, 0, 99, "from ", "%"},
+    {FIELD(humidMaximum), 0, 2, 1, 0, 99, " to ", "%"}}},
+  {"Air temp. range ", 2, {
+    {FIELD(airTempMinimum), FIELD_CELCIUM, 2, 1, 0, 50, "from ", ""},
+    {FIELD(airTempMaximum), FIELD_CELCIUM, 2, 1, 0, 50, " to ", ""}}},
+  {"Substrate temp. ", 1, {
+    {FIELD(subsTempMinimum), FIELD_CELCIUM, 2, 1, 0, 40, "minimum ", ""}}},
+  {"Silent night    ", 2, {
+    {FIELD(silentEvening), FIELD_WRAP, 2, 1, 17, 23, "from ", "h"},
+    {FIELD(silentMorning), FIELD_WRAP, 2, 1, 5, 12, " to ", "h"}}}
+};
+// Duration of emergence on grow profile screen
+static const MenuField emergenceField PROGMEM =
+  {FIELD(emergenceDuration), 0, 4, 1, 1, 255, "duration", " min"};
+
+// Define home screen widgets in order of priority
+static const uint8_t W_STATUS = 0;
+static const uint8_t W_CLOCK = 1;
+static const uint8_t W_AIR = 2;
+static const uint8_t W_SUBSTRATE = 3;
+static const uint8_t W_LIGHT = 4;
+static const uint8_t W_COMPUTER = 5;
+static const uint8_t WIDGETS = 6;
+static const uint8_t STICKY_WIDGETS = 2; // status and clock on every page
+// Widths without the separator column which Layout keeps between widgets
+static const uint8_t widgetWidths[WIDGETS] PROGMEM = {10, 5, 16, 10, 16, 9};
 
 class LcdMenu
 {
@@ -126,28 +183,27 @@ public:
   uint8_t editMode;
   uint8_t menuItem;
   int nextItem;
+  // Throttling of hot computer: refresh period is ONE_SEC << slowdown
+  // when nobody touches buttons, dimmed backlight goes off in 30 sec
+  uint8_t slowdown;
+  bool dimmed;
 
   void begin() {
     // Load settings
     storage.load();
-    // Configure output
-    fdev_setup_stream(&lcd_out, lcd_putchar, NULL, _FDEV_SETUP_WRITE);
     // Configure lcd
-    lcd.begin();
-    // load custom characters
-    lcd.createChar(C_CELCIUM, settings.c_celcium);
-    lcd.createChar(C_HEART, settings.c_heart);
-    lcd.createChar(C_HUMIDITY, settings.c_humidity);
-    lcd.createChar(C_TEMP, settings.c_temp);
-    lcd.createChar(C_FLOWER, settings.c_flower);
-    lcd.createChar(C_LAMP, settings.c_lamp);
-    lcd.createChar(C_UP, settings.c_up);
-    lcd.createChar(C_DOWN, settings.c_down);
+    display.begin();
+    // place home screen widgets
+    layout.arrange(widgetWidths, WIDGETS, STICKY_WIDGETS, 
+      display.cols, display.rows);
+    // load custom characters, CGRAM content is unknown after reset
+    memset(glyphKeys, 0, sizeof(glyphKeys));
+    restoreIcons();
   }
 
   void update() {
     // timer for 1 sec
-    if(millis() - lastUpdate >= ONE_SEC) {
+    if(elapsed(millis(), lastUpdate, refreshPeriod())) {
       lastUpdate = millis();
       // keep home screen and sleeping
       keepDefault();
@@ -157,19 +213,34 @@ public:
       else
         lastUpdate -= 500; // twice faster
       // update lcd
+      #ifdef DEBUG_LCD
+        unsigned long start = micros();
+      #endif
       show();
+      #ifdef DEBUG_LCD
+        printf_P(PSTR("LCD: Info: Screen %d takes: %u us.\n\r"), 
+          menuItem, (unsigned int)(micros()-start));
+      #endif
     }
     // update beep
-    if(states[ERROR] == ERROR_CLOCK || 
-        (settings.silentMorning <= clock.hour() && 
-          clock.hour() < settings.silentEvening)) {
+    if(beepAllowed()) {
       beep.update();
     }
   }
 
+  // Milliseconds till update() has work
+  uint16_t nextUpdate() {
+    uint16_t next = remaining(millis(), lastUpdate, refreshPeriod());
+    if(beepAllowed()) {
+      next = min(next, beep.nextUpdate());
+    }
+    return next;
+  }
+
   void keepDefault() {
     // less 30 sec after touch
-    if(lastTouch+HALF_MIN > lastUpdate || menuItem == EMERGENCE) {
+    if(elapsed(lastUpdate, lastTouch, HALF_MIN) == false || 
+        menuItem == PROFILE) {
       return;
     }
     // return to home
@@ -177,10 +248,11 @@ public:
       menuItem = HOME; 
       editMode = false;
     }
-    // 5 min after touch
-    if(lcd.isBacklight() && lastTouch+(5*ONE_MIN) < lastUpdate) {
+    // 5 min after touch, at once if dimmed
+    if(display.isBacklight() && 
+        (dimmed || elapsed(lastUpdate, lastTouch, 5UL*ONE_MIN))) {
       // switch off backlight
-      lcd.setBacklight(false);
+      display.setBacklight(false);
     }
   }
 
@@ -189,9 +261,11 @@ public:
     if(nextItem != false) {
       lastTouch = millis();
       beep.play(ONE_BEEP);
+      // faults which are gone were seen
+      alarms.acknowledge();
       // enable backlight
-      if(lcd.isBacklight() == false) {
-        lcd.setBacklight(true);
+      if(display.isBacklight() == false) {
+        display.setBacklight(true);
         // reset click
         nextItem = false;
         return;
@@ -203,24 +277,31 @@ public:
       menuItem += nextItem;
       // don't change settings
       nextItem = false;
-      textBlink = false;
-      blinkPos = false;
+      out.textBlink = false;
+      out.blinkPos = false;
       editMode = false;
     }
+    // graph screen borrows custom characters
+    if(menuItem != GRAPH) {
+      restoreIcons();
+    }
     // error screen
-    if(states[ERROR] != NO_ERROR && 
-        lastTouch+HALF_MIN <= lastUpdate) {
+    if(alarms.error() != NO_ERROR && 
+        elapsed(millis(), lastTouch, HALF_MIN)) {
+      enterScreen(ALERT_SCREEN);
       showAlert();
       homeScreenItem = 0;
       return;
     }
     // warning screen
-    if(states[WARNING] != NO_WARNING && 
-        lastTouch+HALF_MIN <= lastUpdate) {
+    if(alarms.warning() != NO_WARNING && 
+        elapsed(millis(), lastTouch, HALF_MIN)) {
+      enterScreen(WARNING_SCREEN);
       showWarning();
       homeScreenItem = 0;
       return;
     }
+    enterScreen(menuItem);
     // main screen
     if(menuItem == HOME) {
       homeScreen();
@@ -236,224 +317,39 @@ public:
   void showMenu() {
     if(editMode != false) {
       // enable blink for edit mode
-      textBlink = true;
+      out.textBlink = true;
       // requested save settings
       storage.changed = true;
     }
     // print menu
-    lcd.home();
+    out.home();
+    if(WATERING_DURATION <= menuItem && menuItem <= SILENT_NIGHT) {
+      settingsScreen(&menuItems[menuItem-WATERING_DURATION]);
+      nextItem = false;
+      return;
+    }
     switch (menuItem) {
 
-      case WATERING_DURATION:
-        fprintf_P(&lcd_out, PSTR("Watering durat. \nfor {%2d} min      "), 
-          settings.wateringDuration += nextItem);
-        break;
-
-      case WATERING_PERIOD:
-        fprintf_P(&lcd_out, PSTR("Watering period \n"));
-        if(settings.wateringSunnyPeriod == 0) {
-          fprintf_P(&lcd_out, PSTR("sun ---/{%3d} min "), 
-            settings.wateringPeriod += nextItem); 
-        } 
-        else if(settings.wateringPeriod == 0) {
-          fprintf_P(&lcd_out, PSTR("sun {%3d}/--- min "), 
-            settings.wateringSunnyPeriod += nextItem); 
-        } else {
-            switch (editMode) {
-              case true:
-                editMode = 4;
-              case 4:
-                blinkPos = 1;
-                settings.wateringSunnyPeriod += nextItem;
-                break;
-              case 3:
-                blinkPos = 2;
-                settings.wateringPeriod += nextItem;
-                break;
-            }  
-            fprintf_P(&lcd_out, PSTR("sun {%3d}/{%3d} min "), 
-              settings.wateringSunnyPeriod, settings.wateringPeriod);
-        }
-        break;
-
-      case MISTING_DURATION:
-        fprintf_P(&lcd_out, PSTR("Misting duration\nfor {%2d} sec      "), 
-          settings.mistingDuration += nextItem);
-        break;
-
-      case MISTING_PERIOD:
-        fprintf_P(&lcd_out, PSTR("Misting period  \n"));
-        if(settings.mistingSunnyPeriod == 0) {
-          fprintf_P(&lcd_out, PSTR("sun ---/{%3d} min "), 
-            settings.mistingPeriod += nextItem); 
-        } 
-        else if(settings.mistingPeriod == 0) {
-          fprintf_P(&lcd_out, PSTR("sun {%3d}/--- min "), 
-            settings.mistingSunnyPeriod += nextItem); 
-        } else {
-            switch (editMode) {
-              case true:
-                editMode = 4;
-              case 4:
-                blinkPos = 1;
-                settings.mistingSunnyPeriod += nextItem;
-                break;
-              case 3:
-                blinkPos = 2;
-                settings.mistingPeriod += nextItem;
-                break;
-            } 
-            fprintf_P(&lcd_out, PSTR("sun {%3d}/{%3d} min "), 
-              settings.mistingSunnyPeriod, settings.mistingPeriod);          
-        }
-        break;
-
-      case LIGHT_DURATION:
-        switch (editMode) {
-          case true:
-            editMode = 4;
-          case 4:
-            blinkPos = 1;
-            settings.lightDayDuration += nextItem;
-            break;
-          case 3:
-            blinkPos = 2;
-            settings.lightMinimum += nextItem;
-            break;
-        }    
-        fprintf_P(&lcd_out, PSTR("Light day       \n{%2d}h with {%4d}lux"),
-          settings.lightDayDuration, settings.lightMinimum);
-        break;
-
-      case LIGHT_DAY_START:
-        fprintf_P(&lcd_out, PSTR("Light day from  \n"));
-        if(editMode == false) {
-          fprintf_P(&lcd_out, PSTR("%02d:%02d to %02d:%02d  "), 
-            settings.lightDayStart/60, settings.lightDayStart%60,
-            (settings.lightDayStart/60)+settings.lightDayDuration, 
-            settings.lightDayStart%60);
-        } else {
-          fprintf_P(&lcd_out, PSTR("{%2d} o'clock      "), 
-            (settings.lightDayStart += (nextItem*60))/60);
-        }
-        break;
-
-      case HUMIDITY_RANGE:
-        switch (editMode) {
-          case true:
-            editMode = 4;
-          case 4:
-            blinkPos = 1;
-            settings.humidMinimum += nextItem;
-            break;
-          case 3:
-            blinkPos = 2;
-            settings.humidMaximum += nextItem;
-            break;
-        }   
-        fprintf_P(&lcd_out, PSTR("Humidity range  \nfrom {%2d}%% to {%2d}%% "),
-          settings.humidMinimum, settings.humidMaximum);
-        break;
-
-      case AIR_TEMP_RANGE:
-        switch (editMode) {
-          case true:
-            editMode = 4;
-          case 4:
-            blinkPos = 1;
-            settings.airTempMinimum += nextItem;
-            break;
-          case 3:
-            blinkPos = 2;
-            settings.airTempMaximum += nextItem;
-            break;
-        }
-        fprintf_P(&lcd_out, PSTR("Air temp. range \nfrom {%2d}%c to {%2d}%c "), 
-          settings.airTempMinimum, C_CELCIUM, settings.airTempMaximum, C_CELCIUM);
-        break; 
-
-      case SUBSTRATE_TEMP_MINIMUM:
-        fprintf_P(&lcd_out, PSTR("Substrate temp. \nminimum {%2d}%c     "), 
-          settings.subsTempMinimum += nextItem, C_CELCIUM);
+      case PROFILE:
+        profileScreen();
         break;
 
-      case SILENT_NIGHT:
-        switch (editMode) {
-          case true:
-            editMode = 4;
-          case 4:
-            blinkPos = 1;
-            settings.silentEvening += nextItem;
-            if(settings.silentEvening > 23)
-              settings.silentEvening = 17;
-            else if(settings.silentEvening < 17)
-              settings.silentEvening = 23;
-            break;
-          case 3:
-            blinkPos = 2;
-            settings.silentMorning += nextItem;
-            if(settings.silentMorning > 12)
-              settings.silentMorning = 5;
-            else if(settings.silentMorning < 5)
-              settings.silentMorning = 12;
-            break;
-        }
-        fprintf_P(&lcd_out, PSTR("Silent night    \nfrom {%2d}h to {%2d}h "),
-          settings.silentEvening, settings.silentMorning);
+      case CLOCK:
+        clockScreen();
         break;
 
-      case EMERGENCE:
-        textBlink = true;
-        switch (editMode) {
-          case false:
-            fprintf_P(&lcd_out, PSTR("Plant emergence \n       -> {Start?}"));
-            // disable emergence mode
-            if(emergenceTimer != false) {   
-              // restore previous settings
-              settings = backup;
-              emergenceTimer = false;
-            }
-            break;
-          case true:
-            editMode = 4;
-          case 4:
-            fprintf_P(&lcd_out, PSTR("Plant emergence \nduration {%3d} min"),
-              settings.emergenceDuration += nextItem);
-            break;
-          case 3:
-            // disable EEPROM store
-            storage.changed = false;
-            // enable emergence mode
-            if(emergenceTimer == false) {
-              // enable timer
-              emergenceTimer = millis()/ONE_MIN;  
-              // save previous settings
-              backup = settings;
-              // change settings for push emergence mode
-              settings.lightMinimum = 20000; // lux
-              settings.lightDayDuration = 18; //hours
-              settings.mistingSunnyPeriod = 5; // min
-              settings.mistingPeriod = 5; //min
-              settings.wateringSunnyPeriod = 2; // min
-              settings.wateringPeriod = 2; //min
-              settings.silentMorning = 0; // hour
-              settings.silentEvening = 24; // hour
-              settings.wateringDuration = 4; //min
-              settings.mistingDuration = 5; //sec
-            }
-            if(millis()/ONE_MIN - emergenceTimer >= settings.emergenceDuration)
-              // exit
-              editMode = false;
-            fprintf_P(&lcd_out, PSTR("Emergence.....  \n%3d min -> {Stop?}"),
-              settings.emergenceDuration - (millis()/ONE_MIN - emergenceTimer));
-            break;
+      case 255: 
+        menuItem = ZONES > 1 ? ZONE : GRAPH;
+        if(menuItem == GRAPH) {
+          graphScreen();
+          break;
         }
+      case ZONE:
+        zoneScreen();
         break;
 
-      case 255: 
-        menuItem = CLOCK;
-      case CLOCK:
-        clockScreen();
+      case GRAPH:
+        graphScreen();
         break;
 
       default:
@@ -467,82 +363,453 @@ private:
   unsigned long lastTouch;
   unsigned long lastUpdate;
   unsigned long emergenceTimer;
+  bool emergence; // emergence profile is running
   uint8_t homeScreenItem;
+  uint8_t graphItem;
+  uint8_t lastScreen;
+  uint8_t menuZone;
+  uint8_t menuProfile;
+  uint8_t glyphKeys[GLYPH_SLOTS]; // range of glyph in CGRAM slot
+
+  // Screens are drawn for 16x2, clear the rest of bigger display
+  // when screen is changed
+  void enterScreen(uint8_t _screen) {
+    if(_screen == lastScreen)
+      return;
+    lastScreen = _screen;
+    if(display.cols > 16 || display.rows > 2)
+      display.clear();
+  }
+
+  // Refresh is slower when it is idle and throttled
+  unsigned long refreshPeriod() {
+    unsigned long period = ONE_SEC;
+    if(editMode == false && elapsed(millis(), lastTouch, HALF_MIN))
+      period <<= slowdown;
+    return period;
+  }
+
+  // Beeps are silent at night unless clock is broken
+  bool beepAllowed() {
+    return alarms.isActive(ERROR_CLOCK) ||
+      (profiles.get(P_SILENT_MORNING) <= clock.hour() &&
+        clock.hour() < profiles.get(P_SILENT_EVENING));
+  }
 
   void backlightBlink(uint8_t _count) {
     for(uint8_t i=0; i<_count; i++) {
-      lcd.setBacklight(false); delay(250);
-      lcd.setBacklight(true); delay(250);
+      display.setBacklight(false); delay(250);
+      display.setBacklight(true); delay(250);
     }
   }
 
   void homeScreen() {
-    textBlink = true;
-    lcd.home();
+    out.textBlink = true;
     if(homeScreenItem >= 16)
       homeScreenItem = 0;
-    
-    if(states[MISTING] == 0 && states[WATERING] == 0)
-      fprintf_P(&lcd_out, PSTR("Sleeping  "));
-    else if(1 <= homeScreenItem && homeScreenItem < 7) 
-      fprintf_P(&lcd_out, PSTR("%c%3d min  "), C_HEART, states[WATERING]);
-    else if(9 <= homeScreenItem && homeScreenItem < 15)
-      fprintf_P(&lcd_out, PSTR("%c%3d min  "), C_FLOWER, states[MISTING]);  
+    // next page every 4 sec
+    uint8_t page = (homeScreenItem/4) % layout.pages;
+    for(uint8_t r=0; r<display.rows; r++) {
+      out.moveTo(0, r);
+      // widgets of row are placed from left to right
+      for(uint8_t w=0; w<layout.count; w++) {
+        if(layout.row[w] != r || !layout.visible(w, page))
+          continue;
+        // separator is cleared too
+        out.clear(layout.col[w]);
+        drawWidget(w);
+        out.clear(layout.col[w] + pgm_read_byte(&widgetWidths[w]));
+      }
+      out.clear(display.cols);
+    }
+    homeScreenItem++;
+  }
+
+  void drawWidget(uint8_t _widget) {
+    switch (_widget) {
+      case W_STATUS:
+        if(states[MISTING] == 0 && states[WATERING] == 0) {
+          out.text_P(PSTR("Sleeping"));
+        } else if(1 <= homeScreenItem && homeScreenItem < 7) {
+          out.text(C_HEART);
+          out.number(states[WATERING], 3);
+          out.text_P(PSTR(" min"));
+        } else if(9 <= homeScreenItem && homeScreenItem < 15) {
+          out.text(C_FLOWER);
+          out.number(states[MISTING], 3);
+          out.text_P(PSTR(" min"));
+        }
+        break;
+      case W_CLOCK:
+        out.number(clock.hour(), 2, '0');
+        out.text_P(PSTR("{:}"));
+        out.number(clock.minute(), 2, '0');
+        break;
+      case W_AIR:
+        out.text_P(PSTR("Air: "));
+        out.text(trendChar(airTempHistory.trend(), C_TEMP));
+        out.text(' ');
+        out.number(states[AIR_TEMP], 2);
+        out.text(C_CELCIUM);
+        out.text(' ');
+        out.text(trendChar(humidityHistory.trend(), C_HUMIDITY));
+        out.text(' ');
+        out.number(states[HUMIDITY], 2);
+        out.text('%');
+        break;
+      case W_SUBSTRATE:
+        out.text_P(PSTR("Sub: "));
+        out.text(trendChar(substrateTempHistory.trend(), C_TEMP));
+        out.text(' ');
+        out.number(states[SUBSTRATE_TEMP], 2);
+        out.text(C_CELCIUM);
+        break;
+      case W_LIGHT:
+        out.text_P(PSTR("Light: "));
+        out.text(trendChar(lightHistory.trend(), C_LAMP));
+        out.text(' ');
+        out.number(states[LIGHT], 4);
+        out.text_P(PSTR("lux"));
+        break;
+      case W_COMPUTER:
+        out.text_P(PSTR("PC: "));
+        out.text(trendChar(computerTempHistory.trend(), C_TEMP));
+        out.text(' ');
+        out.number(states[COMPUTER_TEMP], 2);
+        out.text(C_CELCIUM);
+        break;
+    }
+  }
+
+  // Arrow of sensor trend or sensor icon when it is stable
+  uint8_t trendChar(int8_t _trend, uint8_t _icon) {
+    if(_trend > 0)
+      return C_UP;
+    if(_trend < 0)
+      return C_DOWN;
+    return _icon;
+  }
+
+  // Screen of settings table item, in edit mode editMode counts down
+  // fields from ENHANCED_MODE+count to ENHANCED_MODE which exits
+  void settingsScreen(const MenuItem *_item) {
+    uint8_t count = pgm_read_byte(&_item->count);
+    if(editMode != false) {
+      if(editMode == true)
+        editMode = ENHANCED_MODE + count;
+      uint8_t active = count - (editMode - ENHANCED_MODE);
+      out.blinkPos = active+1;
+      changeField(&_item->fields[active], nextItem);
+    }
+    out.text_P(_item->title);
+    out.newline();
+    for(uint8_t i=0; i<count; i++)
+      printField(&_item->fields[i]);
+    // erase rest of line
+    out.clear(display.cols);
+  }
+
+  uint16_t *fieldValue(const MenuField *_field) {
+    uint8_t *value = (uint8_t *)&settings + pgm_read_byte(&_field->offset);
+    if(pgm_read_byte(&_field->flags) & FIELD_ZONE)
+      value += menuZone*sizeof(ZoneConfig);
+    return (uint16_t *)value;
+  }
+
+  // Step value inside of range
+  void changeField(const MenuField *_field, int _direction) {
+    if(_direction == 0)
+      return;
+    uint8_t flags = pgm_read_byte(&_field->flags);
+    uint16_t minimum = pgm_read_word(&_field->minimum);
+    uint16_t maximum = pgm_read_word(&_field->maximum);
+    uint16_t *value = fieldValue(_field);
+    int32_t next = (flags & FIELD_WORD) ? *value : *(uint8_t *)value;
+    next += _direction * pgm_read_byte(&_field->step);
+    if(next < minimum)
+      next = (flags & FIELD_WRAP) ? maximum : minimum;
+    else if(next > maximum)
+      next = (flags & FIELD_WRAP) ? minimum : maximum;
+    if(flags & FIELD_WORD)
+      *value = next;
     else
-      fprintf_P(&lcd_out, PSTR("          "));
+      *(uint8_t *)value = next;
+  }
+
+  void printField(const MenuField *_field) {
+    uint8_t flags = pgm_read_byte(&_field->flags);
+    uint8_t width = pgm_read_byte(&_field->width);
+    uint16_t *value = fieldValue(_field);
+    uint16_t number = (flags & FIELD_WORD) ? *value : *(uint8_t *)value;
+    out.text_P(_field->prefix);
+    out.blinkBegin();
+    if(flags & FIELD_TIME) {
+      out.time(number/60, number%60);
+    } else if(flags & FIELD_ZERO_OFF && number == 0) {
+      for(uint8_t i=0; i<width; i++)
+        out.text('-');
+    } else {
+      out.number(number, width);
+    }
+    out.blinkEnd();
+    if(flags & FIELD_CELCIUM)
+      out.text(C_CELCIUM);
+    out.text_P(_field->suffix);
+  }
 
-    fprintf_P(&lcd_out, PSTR(" %02d{:}%02d\n"), clock.hour(), clock.minute());
-    switch (homeScreenItem) {
+  void graphScreen() {
+    if(editMode != false) {
+      // choose sensor by buttons
+      storage.changed = false; // don't save EEPROM
+      graphItem += nextItem*4;
+    } else {
+      // next sensor every 4 sec
+      graphItem++;
+    }
+    out.home();
+    switch ((graphItem/4) % 4) {
       case 0:
-        fprintf_P(&lcd_out, PSTR("Air: "));
-        if(states[AIR_TEMP] > states[PREV_AIR_TEMP])
-          fprintf_P(&lcd_out, PSTR("%c "), C_UP);
-        else if(states[AIR_TEMP] < states[PREV_AIR_TEMP])
-          fprintf_P(&lcd_out, PSTR("%c "), C_DOWN);
-        else
-          fprintf_P(&lcd_out, PSTR("%c "), C_TEMP);
-        fprintf_P(&lcd_out, PSTR("%2d%c "), states[AIR_TEMP], C_CELCIUM);
-
-        if(states[HUMIDITY] > states[PREV_HUMIDITY])
-          fprintf_P(&lcd_out, PSTR("%c "), C_UP);
-        else if(states[HUMIDITY] < states[PREV_HUMIDITY])
-          fprintf_P(&lcd_out, PSTR("%c "), C_DOWN);
-        else
-          fprintf_P(&lcd_out, PSTR("%c "), C_HUMIDITY);
-        fprintf_P(&lcd_out, PSTR("%2d%%"), states[HUMIDITY]);
+        drawGraph(PSTR("Air:  "), airTempHistory);
         break;
-      case 4:
-        fprintf_P(&lcd_out, PSTR("Substrate: "));
-        if(states[SUBSTRATE_TEMP] > states[PREV_SUBSTRATE_TEMP])
-          fprintf_P(&lcd_out, PSTR("%c "), C_UP);
-        else if(states[SUBSTRATE_TEMP] < states[PREV_SUBSTRATE_TEMP])
-          fprintf_P(&lcd_out, PSTR("%c "), C_DOWN);
-        else
-          fprintf_P(&lcd_out, PSTR("%c "), C_TEMP);
-        fprintf_P(&lcd_out, PSTR("%2d%c"), states[SUBSTRATE_TEMP], C_CELCIUM);
+      case 1:
+        drawGraph(PSTR("Humid:"), humidityHistory);
         break;
-      case 8:
-        fprintf_P(&lcd_out, PSTR("Light: "));
-        if(states[LIGHT] > states[PREV_LIGHT])
-          fprintf_P(&lcd_out, PSTR("%c "), C_UP);
-        else if(states[LIGHT] < states[PREV_LIGHT])
-          fprintf_P(&lcd_out, PSTR("%c "), C_DOWN);
-        else
-          fprintf_P(&lcd_out, PSTR("%c "), C_LAMP);
-        fprintf_P(&lcd_out, PSTR("%4dlux"), states[LIGHT]);
+      case 2:
+        drawGraph(PSTR("Subst:"), substrateTempHistory);
         break;
-      case 12:
-        fprintf_P(&lcd_out, PSTR("Computer:  "));
-        if(states[COMPUTER_TEMP] > states[PREV_COMPUTER_TEMP])
-          fprintf_P(&lcd_out, PSTR("%c "), C_UP);
-        else if(states[COMPUTER_TEMP] < states[PREV_COMPUTER_TEMP])
-          fprintf_P(&lcd_out, PSTR("%c "), C_DOWN);
-        else
-          fprintf_P(&lcd_out, PSTR("%c "), C_TEMP);
-        fprintf_P(&lcd_out, PSTR("%2d%c"), states[COMPUTER_TEMP], C_CELCIUM);
+      case 3:
+        drawGraph(PSTR("Light:"), lightHistory);
         break;
     }
-    homeScreenItem++;
+  }
+
+  // Sparkline of last hours, each column is min-max range of the hour
+  template<typename T, typename S, uint8_t SHIFT>
+  void drawGraph(const char *_title, History<T, S, SHIFT>& _history) {
+    uint8_t columns[GRAPH_COLUMNS];
+    uint8_t hours = min(_history.hoursCount(), GRAPH_COLUMNS);
+    T low = 0, high = 0;
+    for(uint8_t i=0; i<hours; i++) {
+      if(i == 0 || _history.hourMin(i) < low)
+        low = _history.hourMin(i);
+      if(i == 0 || _history.hourMax(i) > high)
+        high = _history.hourMax(i);
+    }
+    out.text_P(_title);
+    out.number(low, 4);
+    out.text('-');
+    out.number(high, 0);
+    out.clear(display.cols);
+    // newest hour is on the right
+    for(uint8_t i=0; i<GRAPH_COLUMNS; i++) {
+      uint8_t ago = GRAPH_COLUMNS-1-i;
+      if(ago >= hours) {
+        columns[i] = GLYPH_EMPTY;
+        continue;
+      }
+      columns[i] = graphLevel(_history.hourMin(ago), low, high) << 3 | 
+        graphLevel(_history.hourMax(ago), low, high);
+    }
+    drawColumns(columns);
+  }
+
+  // Row 0-7 of value, middle one for flat graph
+  template<typename T>
+  uint8_t graphLevel(T _value, T _low, T _high) {
+    if(_high == _low)
+      return 3;
+    return (uint32_t)(_value - _low) * 7 / (_high - _low);
+  }
+
+  // Glyphs are shared by identical columns, the most used ranges are
+  // cached in CGRAM and the rest take the nearest cached range.
+  // Only slots with changed range are uploaded.
+  void drawColumns(uint8_t *_columns) {
+    uint8_t keys[GRAPH_COLUMNS], uses[GRAPH_COLUMNS];
+    uint8_t count = 0;
+    // count usage of ranges
+    for(uint8_t i=0; i<GRAPH_COLUMNS; i++) {
+      if(_columns[i] == GLYPH_EMPTY || _columns[i] == GLYPH_FULL)
+        continue;
+      uint8_t k = 0;
+      while(k < count && keys[k] != _columns[i])
+        k++;
+      if(k == count) {
+        keys[count] = _columns[i];
+        uses[count++] = 0;
+      }
+      uses[k]++;
+    }
+    // most used ranges first
+    for(uint8_t i=1; i<count; i++) {
+      for(uint8_t j=i; j>0 && uses[j] > uses[j-1]; j--) {
+        uint8_t key = keys[j]; keys[j] = keys[j-1]; keys[j-1] = key;
+        uint8_t use = uses[j]; uses[j] = uses[j-1]; uses[j-1] = use;
+      }
+    }
+    if(count > GLYPH_SLOTS)
+      count = GLYPH_SLOTS;
+    // keep slots which already have needed range
+    uint8_t slots[GLYPH_SLOTS];
+    bool kept[GLYPH_SLOTS] = {false};
+    for(uint8_t k=0; k<count; k++) {
+      slots[k] = GLYPH_SLOTS;
+      for(uint8_t s=0; s<GLYPH_SLOTS; s++) {
+        if(glyphKeys[s] == keys[k]) {
+          slots[k] = s;
+          kept[s] = true;
+          break;
+        }
+      }
+    }
+    // upload new ranges into free slots
+    uint8_t s = 0;
+    for(uint8_t k=0; k<count; k++) {
+      if(slots[k] != GLYPH_SLOTS)
+        continue;
+      while(kept[s])
+        s++;
+      uploadGlyph(s, keys[k]);
+      slots[k] = s;
+      kept[s] = true;
+    }
+    // draw columns
+    out.newline();
+    for(uint8_t i=0; i<GRAPH_COLUMNS; i++) {
+      if(_columns[i] == GLYPH_EMPTY) {
+        out.text(' ');
+      } else if(_columns[i] == GLYPH_FULL) {
+        out.text(LCD_BLOCK);
+      } else {
+        out.text(slots[nearestGlyph(keys, count, _columns[i])]);
+      }
+    }
+  }
+
+  uint8_t nearestGlyph(uint8_t *_keys, uint8_t _count, uint8_t _key) {
+    uint8_t nearest = 0, best = 0xFF;
+    for(uint8_t k=0; k<_count; k++) {
+      uint8_t distance = abs((_keys[k] >> 3) - (_key >> 3)) + 
+        abs((_keys[k] & 7) - (_key & 7));
+      if(distance < best) {
+        best = distance;
+        nearest = k;
+      }
+    }
+    return nearest;
+  }
+
+  void uploadGlyph(uint8_t _slot, uint8_t _key) {
+    uint8_t rows[8];
+    uint8_t low = _key >> 3, high = _key & 7;
+    // top row is the first
+    for(uint8_t r=0; r<8; r++)
+      rows[r] = (7-r >= low && 7-r <= high) ? 0x1F : 0;
+    display.createChar(_slot, rows);
+    glyphKeys[_slot] = _key;
+  }
+
+  // Load back custom characters taken by graph
+  void restoreIcons() {
+    for(uint8_t s=0; s<GLYPH_SLOTS; s++) {
+      if(glyphKeys[s] == GLYPH_ICON)
+        continue;
+      // icons follow each other in settings by slot order
+      display.createChar(s, settings.c_celcium + s*8);
+      glyphKeys[s] = GLYPH_ICON;
+    }
+  }
+
+  // Zone of watering and misting settings
+  void zoneScreen() {
+    if(ZONES == 1) {
+      menuItem = HOME;
+      return;
+    }
+    // don't save EEPROM
+    storage.changed = false;
+    if(editMode != false) {
+      menuZone += nextItem;
+      if(menuZone >= ZONES)
+        menuZone = nextItem > 0 ? 0 : ZONES-1;
+    }
+    out.text_P(PSTR("Settings of     \nzone "));
+    out.field(menuZone+1, 1);
+    out.text_P(PSTR(" of "));
+    out.number(ZONES, 1);
+    out.clear(display.cols);
+  }
+
+  // Grow plan is chosen and started from today, emergence runs over
+  // the plan for its duration or till stop. Day of phase is shown.
+  void profileScreen() {
+    out.textBlink = true;
+    switch (editMode) {
+      case false:
+        // disable emergence mode
+        if(emergence) {
+          calendar.resume();
+          emergence = false;
+        }
+        out.text_P(PSTR("Grow profile"));
+        if(calendar.phaseDay() != 0xFFFF && 
+            settings.profile != PROFILE_MANUAL) {
+          out.number(calendar.phaseDay(), 3);
+          out.text('d');
+        }
+        out.clear(16);
+        out.newline();
+        out.text_P(Profiles::name(settings.profile));
+        out.clear(11);
+        out.text_P(PSTR("{Set?}"));
+        break;
+      case true:
+        editMode = 5;
+        menuProfile = settings.profile;
+      case 5:
+        // don't save EEPROM
+        storage.changed = false;
+        menuProfile += nextItem;
+        if(menuProfile >= PROFILES)
+          menuProfile = nextItem > 0 ? 0 : PROFILES-1;
+        out.text_P(PSTR("Grow profile    \n"));
+        out.blinkBegin();
+        out.text_P(Profiles::name(menuProfile));
+        out.blinkEnd();
+        break;
+      case 4:
+        if(menuProfile != PROFILE_EMERGENCE) {
+          // start plan, days are counted from 2000
+          calendar.start(menuProfile, clock.secondstime()/86400L);
+          editMode = false;
+          profileScreen();
+          return;
+        }
+        changeField(&emergenceField, nextItem);
+        out.text_P(PSTR("Plant emergence \n"));
+        printField(&emergenceField);
+        break;
+      case 3:
+        // disable EEPROM store
+        storage.changed = false;
+        // enable emergence mode
+        if(emergence == false) {
+          // enable timer, it can start at minute 0 of uptime
+          emergence = true;
+          emergenceTimer = uptime.minutes();
+          profiles.select(PROFILE_EMERGENCE);
+        }
+        if(elapsed(uptime.minutes(), emergenceTimer, 
+            settings.emergenceDuration))
+          // exit
+          editMode = false;
+        out.text_P(PSTR("Emergence.....  \n"));
+        out.number(settings.emergenceDuration - 
+          (uptime.minutes() - emergenceTimer), 3);
+        out.text_P(PSTR(" min -> {Stop?}"));
+        break;
+    }
+    out.clear(display.cols);
   }
 
   void clockScreen() {
@@ -553,8 +820,16 @@ private:
     uint16_t year = clock.year();
     // show clock
     if(editMode == false) {
-      fprintf_P(&lcd_out, PSTR("Time:   %02d:%02d:%02d\nDate: %02d-%02d-%4d"), 
-        hour, minute, clock.second(), day, month, year);
+      out.text_P(PSTR("Time:   "));
+      out.time(hour, minute);
+      out.text(':');
+      out.number(clock.second(), 2, '0');
+      out.text_P(PSTR("\nDate: "));
+      out.number(day, 2, '0');
+      out.text('-');
+      out.number(month, 2, '0');
+      out.text('-');
+      out.number(year, 4);
       return;
     }
     // edit mode
@@ -563,107 +838,133 @@ private:
       case true:
         editMode = 7;
       case 7:
-        blinkPos = 1;
+        out.blinkPos = 1;
         hour += nextItem;
         if(hour > 23)
           hour = 0;
         break;
       case 6:
-        blinkPos = 2;
+        out.blinkPos = 2;
         minute += nextItem;
         if(minute > 59)
           minute = 0;
         break;
       case 5:
-        blinkPos = 3;
+        out.blinkPos = 3;
         day += nextItem;
         if(day < 1 || day > 31)
           day = 1;
         break;
       case 4:
-        blinkPos = 4;
+        out.blinkPos = 4;
         month += nextItem;
         if(month < 1 || month > 12)
           month = 1;
         break;
       case 3:
-        blinkPos = 5;
+        out.blinkPos = 5;
         year += nextItem;
-        if(year < 2014 || year > 2024)
-          year = 2014; 
+        if(year < CLOCK_YEAR_MINIMUM || year > CLOCK_YEAR_MAXIMUM)
+          year = CLOCK_YEAR_MINIMUM;
         break;
     }
-    fprintf_P(&lcd_out, PSTR("Setting time    \n{%02d}:{%02d} {%02d}-{%02d}-{%4d}"), 
-      hour, minute, day, month, year);
+    out.text_P(PSTR("Setting time    \n"));
+    out.field(hour, 2, '0');
+    out.text(':');
+    out.field(minute, 2, '0');
+    out.text(' ');
+    out.field(day, 2, '0');
+    out.text('-');
+    out.field(month, 2, '0');
+    out.text('-');
+    out.field(year, 4);
     clock = DateTime(year, month, day, hour, minute);
   }
 
   void showWarning() {
-    lcd.setBacklight(true);
-    textBlink = true;
-    lcd.home();
-    switch (states[WARNING]) { 
+    if(dimmed == false)
+      display.setBacklight(true);
+    out.textBlink = true;
+    out.home();
+    switch (alarms.warning()) { 
       case WARNING_SUBSTRATE_LOW:
-        fprintf_P(&lcd_out, PSTR("Low substrate!  \n{Please add some!}"));
+        out.text_P(PSTR("Low substrate!  \n{Please add some!}"));
         return;
       case INFO_SUBSTRATE_FULL:
-        fprintf_P(&lcd_out, PSTR("Substrate tank  \nis full! :)))   "));
+        out.text_P(PSTR("Substrate tank  \nis full! :)))   "));
         backlightBlink(ONE_BLINK);
         return;
       case INFO_SUBSTRATE_DELIVERED:
-        fprintf_P(&lcd_out, PSTR("Substrate was   \ndelivered! :))) "));
+        out.text_P(PSTR("Substrate was   \ndelivered! :))) "));
         return;
       case WARNING_SUBSTRATE_COLD:
-        fprintf_P(&lcd_out, PSTR("Substrate is too\ncold! {:(}        "));
+        out.text_P(PSTR("Substrate is too\ncold! {:(}        "));
         beep.play(TWO_BEEP);
         return;
       case WARNING_AIR_COLD:
-        fprintf_P(&lcd_out, PSTR("Air is too cold \nfor plants! {:(}  "));
+        out.text_P(PSTR("Air is too cold \nfor plants! {:(}  "));
         beep.play(ONE_BEEP);
         return;
       case WARNING_AIR_HOT:
-        fprintf_P(&lcd_out, PSTR("Air is too hot \nfor plants! {:(}  "));
+        out.text_P(PSTR("Air is too hot \nfor plants! {:(}  "));
         beep.play(ONE_BEEP);
         return;
+      case WARNING_REFILL_SUBSTRATE:
+        out.text_P(PSTR("Substrate "));
+        refillScreen(states[SUBSTRATE_LEVEL], substrateTank.hoursLeft());
+        return;
+      case WARNING_REFILL_WATER:
+        out.text_P(PSTR("Water "));
+        refillScreen(states[WATER_LEVEL], waterTank.hoursLeft());
+        return;
       case WARNING_NO_WATER:
-        fprintf_P(&lcd_out, PSTR("Misting error!  \nNo water! {:(}    "));
+        out.text_P(PSTR("Misting error!  \nNo water! {:(}    "));
         beep.play(ONE_BEEP);
         return;                
       case WARNING_WATERING:
-        fprintf_P(&lcd_out, PSTR("Watering...     \n{Please wait.}    "));
+        out.text_P(PSTR("Watering...     \n{Please wait.}    "));
         return;
       case WARNING_MISTING:
-        fprintf_P(&lcd_out, PSTR("Misting...      \nPlease wait.    "));
+        out.text_P(PSTR("Misting...      \nPlease wait.    "));
         return;
     }  
   }
 
+  void refillScreen(uint8_t _percent, uint16_t _hours) {
+    out.number(_percent, 3);
+    out.text('%');
+    out.clear(display.cols);
+    out.text_P(PSTR("\nends in "));
+    out.field(_hours, 3);
+    out.text_P(PSTR(" h  "));
+  }
+
   void showAlert() {
     beep.play(FIVE_BEEP);
     backlightBlink(ONE_BLINK);
-    textBlink = true;
-    lcd.home();
-    switch (states[ERROR]) {
+    out.textBlink = true;
+    out.home();
+    switch (alarms.error()) {
       case ERROR_LOW_MEMORY:
-        fprintf_P(&lcd_out, PSTR("MEMORY ERROR!   \n{Low memory!}     "));
+        out.text_P(PSTR("MEMORY ERROR!   \n{Low memory!}     "));
         return;
       case ERROR_EEPROM:
-        fprintf_P(&lcd_out, PSTR("EEPROM ERROR!   \n{Settings reset!} "));
+        out.text_P(PSTR("EEPROM ERROR!   \n{Settings reset!} "));
         return;
       case ERROR_DHT:
-        fprintf_P(&lcd_out, PSTR("DHT ERROR!      \n{Check connection}"));
+        out.text_P(PSTR("DHT ERROR!      \n{Check connection}"));
         return;
       case ERROR_BH1750:
-        fprintf_P(&lcd_out, PSTR("BH1750 ERROR!   \n{Check connection}"));
+        out.text_P(PSTR("BH1750 ERROR!   \n{Check connection}"));
         return;
       case ERROR_DS18B20:
-        fprintf_P(&lcd_out, PSTR("DS18B20 ERROR!  \n{Check connection}"));
+        out.text_P(PSTR("DS18B20 ERROR!  \n{Check connection}"));
         return;
       case ERROR_NO_SUBSTRATE:
-        fprintf_P(&lcd_out, PSTR("No substrate!   \n{Plants can die!} "));
+        out.text_P(PSTR("No substrate!   \n{Plants can die!} "));
         return;
       case ERROR_CLOCK:
-        fprintf_P(&lcd_out, PSTR("Clock ERROR!    \n{Set up clock!}   "));
+        out.text_P(PSTR("Clock ERROR!    \n{Set up clock!}   "));
         return;
     }  
   }
@@ -62,6 +62,14 @@ public:
     rightButton.tick();
   }
 
+  // Milliseconds till update() has work, buttons are polled while
+  // they are pressed
+  uint16_t nextUpdate() {
+    if(leftButton.isIdle() == false || rightButton.isIdle() == false)
+      return 0;
+    return menu.nextUpdate();
+  }
+
 };
 
 #endif // __LCDPANEL_H__
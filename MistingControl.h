@@ -0,0 +1,96 @@
+#ifndef MISTINGCONTROL_H
+#define MISTINGCONTROL_H
+
+//#define DEBUG_MISTING
+// Halve or double misting period at humidity limits instead of the PI
+// controller, simulator compares both
+//#define MISTING_LEGACY
+
+// Misting rate factor in 1/256, 256 is the period of settings
+static const uint16_t RATE_NOMINAL = 256;
+static const uint16_t RATE_MIN = 64; // 4 times rarely
+static const uint16_t RATE_MAX = 1024; // 4 times often
+// Duration takes rate changes up to +-25%, interval takes the rest
+static const uint16_t DURATION_RATE_MIN = 192;
+static const uint16_t DURATION_RATE_MAX = 320;
+// Gains in 1/256 of rate per percent of humidity error
+static const uint8_t MISTING_KP = 12;
+static const uint8_t MISTING_KI = 1; // per minute
+// Integral adds at most half of nominal rate, humidity which misting
+// can't reach doesn't hold the rate at maximum
+static const int16_t MISTING_INTEGRAL_MAX = 128;
+// Max rate change per update is 1/8 of current rate
+static const uint8_t RATE_SLEW_SHIFT = 3;
+
+// PI controller of misting by air humidity. It runs once a minute on
+// the error from the middle of humidity range and gives a rate factor.
+// Integral isn't accumulated while rate is saturated (anti-windup) and
+// rate changes slowly, so misting doesn't jump between extremes.
+class MistingControl
+{
+public:
+  uint16_t rate;
+
+  MistingControl() : rate(RATE_NOMINAL), integral(0) {}
+
+#ifdef MISTING_LEGACY
+  void update(uint8_t _humidity, uint8_t _minimum, uint8_t _maximum) {
+    if(_humidity <= _minimum)
+      rate = 2*RATE_NOMINAL; // twice often
+    else if(_humidity >= _maximum)
+      rate = RATE_NOMINAL/2; // twice rarely
+    else
+      rate = RATE_NOMINAL;
+  }
+
+  // Minutes between misting, 0 stays off
+  uint16_t interval(uint8_t _period) {
+    return (uint32_t)_period*RATE_NOMINAL/rate;
+  }
+
+  // Seconds of misting
+  uint8_t duration(uint8_t _seconds) {
+    return _seconds;
+  }
+#else
+  void update(uint8_t _humidity, uint8_t _minimum, uint8_t _maximum) {
+    int16_t error = ((int16_t)_minimum + _maximum)/2 - _humidity;
+    int16_t target = RATE_NOMINAL + MISTING_KP*error + integral;
+    bool saturated = (target >= (int16_t)RATE_MAX && error > 0) ||
+      (target <= (int16_t)RATE_MIN && error < 0);
+    if(saturated == false) {
+      integral = constrain(integral + MISTING_KI*error,
+        -MISTING_INTEGRAL_MAX, MISTING_INTEGRAL_MAX);
+    }
+    target = constrain(target, (int16_t)RATE_MIN, (int16_t)RATE_MAX);
+    // slew limit
+    int16_t step = max(rate >> RATE_SLEW_SHIFT, 1);
+    rate = constrain(target, (int16_t)rate - step, (int16_t)rate + step);
+    #ifdef DEBUG_MISTING
+      printf_P(PSTR("MISTING: Info: Humidity error %d%%, integral %d, rate %u/256.\n\r"),
+        error, integral, rate);
+    #endif
+  }
+
+  // Minutes between misting, 0 stays off
+  uint16_t interval(uint8_t _period) {
+    return _period == 0 ? 0 :
+      max((uint32_t)_period*durationRate()/rate, 1);
+  }
+
+  // Seconds of misting
+  uint8_t duration(uint8_t _seconds) {
+    uint16_t value = ((uint16_t)_seconds*durationRate() + 128) >> 8;
+    return constrain(value, 1, 255);
+  }
+#endif
+
+private:
+  int16_t integral;
+
+  uint16_t durationRate() {
+    return constrain(rate, DURATION_RATE_MIN, DURATION_RATE_MAX);
+  }
+};
+
+#endif // __MISTINGCONTROL_H__
@@ -14,6 +14,7 @@
 // -----
 
 #include "OneButton.h"
+#include "Elapsed.h"
 
 // ----- Initialization and Default Values -----
 
@@ -99,6 +100,10 @@ bool OneButton::isLongPressed(){
   return _isLongPressed;
 }
 
+bool OneButton::isIdle(){
+  return _state == 0;
+}
+
 void OneButton::tick(void)
 {
   // Detect the input information 
@@ -116,7 +121,7 @@ void OneButton::tick(void)
     if (buttonLevel == _buttonReleased) {
       _state = 2; // step to state 2
 
-    } else if ((buttonLevel == _buttonPressed) && (now > _startTime + _pressTicks)) {
+    } else if ((buttonLevel == _buttonPressed) && elapsed(now, _startTime, _pressTicks)) {
       _isLongPressed = true;  // Keep track of long press state
       if (_pressFunc) _pressFunc();
 	  if (_longPressStartFunc) _longPressStartFunc();
@@ -128,7 +133,7 @@ void OneButton::tick(void)
     } // if
 
   } else if (_state == 2) { // waiting for menu pin being pressed the second time or timeout.
-    if (now > _startTime + _clickTicks) {
+    if (elapsed(now, _startTime, _clickTicks)) {
       // this was only a single short click
       if (_clickFunc) _clickFunc();
       _state = 0; // restart.
@@ -50,6 +50,8 @@ public:
   // call this function every some milliseconds for handling button events.
   void tick(void);
   bool isLongPressed();
+  // button is released and no click is pending, tick() has nothing to do
+  bool isIdle();
 
 private:
   int _pin;        // hardware pin number. 
@@ -30,13 +30,17 @@
 #define ONEWIRE_CRC 1
 #endif
 
-// Select the table-lookup method of computing the 8-bit CRC
-// by setting this to 1.  The lookup table enlarges code size by
-// about 250 bytes.  It does NOT consume RAM (but did in very
-// old versions of OneWire).  If you disable this, a slower
-// but very compact algorithm is used.
+// CRC kernels, select one per board to trade flash for speed:
+#define ONEWIRE_CRC_BITWISE 0  // slow but very compact, no table
+#define ONEWIRE_CRC_TABLE 1    // 256 entries table in flash, one lookup per byte
+#define ONEWIRE_CRC_NIBBLE 2   // 16 entries table in flash, two lookups per byte
+
+// Select the method of computing the 8-bit CRC. The 256 entries
+// lookup table enlarges code size by about 250 bytes, the nibble
+// table by 16 bytes.  They do NOT consume RAM (but did in very
+// old versions of OneWire).
 #ifndef ONEWIRE_CRC8_TABLE
-#define ONEWIRE_CRC8_TABLE 1
+#define ONEWIRE_CRC8_TABLE ONEWIRE_CRC_TABLE
 #endif
 
 // You can allow 16-bit CRC checks by defining this to 1
@@ -45,6 +49,13 @@
 #define ONEWIRE_CRC16 0
 #endif
 
+// Select the method of computing the 16-bit CRC. The 256 entries
+// lookup table enlarges code size by 512 bytes, the nibble table
+// by 32 bytes.
+#ifndef ONEWIRE_CRC16_TABLE
+#define ONEWIRE_CRC16_TABLE ONEWIRE_CRC_BITWISE
+#endif
+
 #define FALSE 0
 #define TRUE  1
 
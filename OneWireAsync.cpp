@@ -0,0 +1,172 @@
+#include "OneWireAsync.h"
+
+// Transaction phases
+#define PHASE_IDLE 0
+#define PHASE_RESET_RELEASE 1
+#define PHASE_RESET_SAMPLE 2
+#define PHASE_RESET_DONE 3
+#define PHASE_SLOT 4
+#define PHASE_WRITE_ZERO_RELEASE 5
+
+// Timer1 ticks per microsecond with prescaler 8
+#define TICKS_PER_US (clockCyclesPerMicrosecond() / 8)
+
+OneWireAsync *OneWireAsync::active = NULL;
+
+OneWireAsync::OneWireAsync(uint8_t pin)
+{
+	bitmask = PIN_TO_BITMASK(pin);
+	baseReg = PIN_TO_BASEREG(pin);
+	_phase = PHASE_IDLE;
+}
+
+void OneWireAsync::begin(void)
+{
+	active = this;
+	// normal mode, prescaler 8
+	TCCR1A = 0;
+	TCCR1B = _BV(CS11);
+	TIMSK1 &= ~_BV(OCIE1A);
+}
+
+bool OneWireAsync::start(uint8_t *buffer, uint8_t writeCount, uint8_t readCount,
+		bool power, oneWireCallback callback, void *context)
+{
+	if (_phase != PHASE_IDLE || writeCount + readCount > 31)
+		return false;
+
+	_buffer = buffer;
+	_writeBits = writeCount * 8;
+	_totalBits = (writeCount + readCount) * 8;
+	_position = 0;
+	_power = power;
+	_callback = callback;
+	_context = context;
+	// read bits are set only
+	for (uint8_t i = writeCount; i < writeCount + readCount; i++)
+		buffer[i] = 0;
+
+	// can be called from the interrupt, keep its state
+	uint8_t oldSREG = SREG;
+	cli();
+	// drive the bus low for reset pulse (Trstl)
+	DIRECT_WRITE_LOW(baseReg, bitmask);
+	DIRECT_MODE_OUTPUT(baseReg, bitmask);
+	_phase = PHASE_RESET_RELEASE;
+	_schedule(480);
+	SREG = oldSREG;
+	return true;
+}
+
+bool OneWireAsync::busy(void)
+{
+	return _phase != PHASE_IDLE;
+}
+
+//
+// Each phase ends with scheduling of the next one, the long waits
+// of a slot pass in the background. Short edges (up to 13us) are
+// done in place like in OneWire::write_bit() and read_bit().
+//
+void OneWireAsync::handleInterrupt(void)
+{
+	IO_REG_TYPE mask = bitmask;
+	volatile IO_REG_TYPE *reg IO_REG_ASM = baseReg;
+
+	switch (_phase) {
+		case PHASE_RESET_RELEASE:
+			DIRECT_MODE_INPUT(reg, mask);	// stop driving low
+			DIRECT_WRITE_HIGH(reg, mask);	// enable pull-up resistor
+			_phase = PHASE_RESET_SAMPLE;
+			_schedule(70);					// slaves pull bus low
+			return;
+		case PHASE_RESET_SAMPLE:
+			_presence = !DIRECT_READ(reg, mask);
+			_phase = PHASE_RESET_DONE;
+			_schedule(410);					// end of presence pulse
+			return;
+		case PHASE_RESET_DONE:
+			if (!DIRECT_READ(reg, mask)) {
+				_finish(ONEWIRE_ASYNC_BUS_FAIL);
+				return;
+			}
+			if (!_presence) {
+				_finish(ONEWIRE_ASYNC_NO_PRESENCE);
+				return;
+			}
+			break;
+		case PHASE_WRITE_ZERO_RELEASE:
+			DIRECT_WRITE_HIGH(reg, mask);	// drive high
+			delayMicroseconds(5);			// recovery (Trec)
+			break;
+		case PHASE_SLOT:
+			break;
+		default:
+			return;
+	}
+	_slot();
+}
+
+void OneWireAsync::_slot(void)
+{
+	IO_REG_TYPE mask = bitmask;
+	volatile IO_REG_TYPE *reg IO_REG_ASM = baseReg;
+
+	if (_position >= _totalBits) {
+		// if power not requested, then enable pull-up
+		if (!_power)
+			DIRECT_MODE_INPUT(reg, mask);
+		_finish(ONEWIRE_ASYNC_OK);
+		return;
+	}
+
+	uint8_t *value = _buffer + (_position >> 3);
+	uint8_t bit = 1 << (_position & 7);
+	_phase = PHASE_SLOT;
+
+	if (_position++ < _writeBits) {
+		DIRECT_WRITE_LOW(reg, mask);
+		DIRECT_MODE_OUTPUT(reg, mask);	// drive output low
+		if (*value & bit) {
+			delayMicroseconds(10);
+			DIRECT_WRITE_HIGH(reg, mask);	// drive output high
+			_schedule(55);
+		} else {
+			_phase = PHASE_WRITE_ZERO_RELEASE;
+			_schedule(65);					// slave samples 15us-60us
+		}
+		return;
+	}
+
+	DIRECT_WRITE_LOW(reg, mask);
+	DIRECT_MODE_OUTPUT(reg, mask);
+	delayMicroseconds(3);				// initiate read slot (Tint)
+	DIRECT_MODE_INPUT(reg, mask);		// let pin float, pull up will raise
+	DIRECT_WRITE_HIGH(reg, mask);
+	delayMicroseconds(10);				// allow time for signal to rise (Trc)
+	if (DIRECT_READ(reg, mask))
+		*value |= bit;
+	_schedule(53);						// rest of the slot and recovery
+}
+
+void OneWireAsync::_schedule(uint16_t us)
+{
+	OCR1A = TCNT1 + us * TICKS_PER_US;
+	TIFR1 = _BV(OCF1A);
+	TIMSK1 |= _BV(OCIE1A);
+}
+
+void OneWireAsync::_finish(uint8_t status)
+{
+	TIMSK1 &= ~_BV(OCIE1A);
+	_phase = PHASE_IDLE;
+	// callback may start the next transaction
+	if (_callback)
+		_callback(_context, status);
+}
+
+ISR(TIMER1_COMPA_vect)
+{
+	if (OneWireAsync::active)
+		OneWireAsync::active->handleInterrupt();
+}
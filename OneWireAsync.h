@@ -0,0 +1,64 @@
+#ifndef OneWireAsync_h
+#define OneWireAsync_h
+
+#include "OneWire.h"
+
+// Background 1-Wire transactions driven by Timer1 compare interrupt.
+// Timer1 runs free with prescaler 8, every bit slot is scheduled by
+// OCR1A, so the CPU is busy only for the short edges of a slot instead
+// of the whole transaction. Timer1 PWM (pins 9 and 10) isn't available.
+
+// Transaction status
+#define ONEWIRE_ASYNC_OK 0
+#define ONEWIRE_ASYNC_NO_PRESENCE 1
+#define ONEWIRE_ASYNC_BUS_FAIL 2
+
+// Completion callback, it is called from the interrupt
+extern "C" {
+  typedef void (*oneWireCallback)(void *context, uint8_t status);
+}
+
+class OneWireAsync
+{
+  public:
+    OneWireAsync(uint8_t pin);
+
+    // Configure Timer1, call it once from setup()
+    void begin(void);
+
+    // Start a transaction: reset, write 'writeCount' bytes from buffer
+    // and read 'readCount' bytes into buffer after the written ones.
+    // If 'power' is true the bus is driven high at the end for
+    // parasite powered devices. Returns false if the bus is busy.
+    // Can be called from a completion callback to chain transactions.
+    bool start(uint8_t *buffer, uint8_t writeCount, uint8_t readCount,
+      bool power, oneWireCallback callback, void *context);
+
+    // Returns true while a transaction is in progress
+    bool busy(void);
+
+    // Timer1 compare interrupt handler
+    void handleInterrupt(void);
+
+    static OneWireAsync *active;
+
+  private:
+    IO_REG_TYPE bitmask;
+    volatile IO_REG_TYPE *baseReg;
+
+    volatile uint8_t _phase;
+    uint8_t *_buffer;
+    uint8_t _writeBits;
+    uint8_t _totalBits;
+    uint8_t _position;
+    bool _power;
+    bool _presence;
+    oneWireCallback _callback;
+    void *_context;
+
+    void _slot(void);
+    void _schedule(uint16_t us);
+    void _finish(uint8_t status);
+};
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef PROFILES_H
+#define PROFILES_H
+
+#include <stddef.h>
+#include <avr/pgmspace.h>
+#include "SettingsStruct.h"
+
+//#define DEBUG_PROFILES
+
+// Parameters which profiles can change, bit of profile mask. Zone
+// parameters are changed in every zone.
+static const uint8_t P_LIGHT_MINIMUM = 0;
+static const uint8_t P_LIGHT_DURATION = 1;
+static const uint8_t P_SILENT_MORNING = 2;
+static const uint8_t P_SILENT_EVENING = 3;
+static const uint8_t P_HUMID_MINIMUM = 4;
+static const uint8_t P_HUMID_MAXIMUM = 5;
+static const uint8_t P_WATERING_DURATION = 6;
+static const uint8_t P_WATERING_SUNNY = 7;
+static const uint8_t P_WATERING_PERIOD = 8;
+static const uint8_t P_MISTING_DURATION = 9;
+static const uint8_t P_MISTING_SUNNY = 10;
+static const uint8_t P_MISTING_PERIOD = 11;
+static const uint8_t PROFILE_PARAMS = 12;
+static const uint8_t ZONE_PARAMS = 6; // last ones
+// Slots of parameter values for all zones
+static const uint8_t PROFILE_SLOTS = PROFILE_PARAMS + (ZONES-1)*ZONE_PARAMS;
+// Define parameter flags
+static const uint8_t PARAM_WORD = 1; // uint16_t value
+static const uint8_t PARAM_ZONE = 2; // field of zone config
+// Profiles in order of table
+static const uint8_t PROFILE_MANUAL = 0; // settings as they are
+static const uint8_t PROFILE_EMERGENCE = 1; // push plant emergence
+static const uint8_t PROFILE_SEEDLING = 2;
+static const uint8_t PROFILE_VEGETATIVE = 3;
+static const uint8_t PROFILE_FLOWERING = 4;
+static const uint8_t PROFILE_FLUSH = 5; // plain water before harvest
+static const uint8_t PROFILES = 6;
+
+// Field of settings which profile can change
+struct ProfileParam {
+  uint8_t offset; // in SettingsStruct
+  uint8_t flags;
+};
+
+// Grow profile is a sparse delta from settings: mask has a bit of every
+// changed parameter and values of them follow in order of bits from
+// first value in pool. Profile with days is a phase of grow calendar,
+// it moves on to next one when they are passed, 0 keeps it. During
+// last blend days of phase values go over to next one.
+struct Profile {
+  char name[11];
+  uint16_t mask;
+  uint8_t first;
+  uint8_t days, blend, next;
+};
+
+#define PROFILE_PARAM(name, flags) {offsetof(SettingsStruct, name), flags}
+
+static const ProfileParam profileParams[PROFILE_PARAMS] PROGMEM = {
+  PROFILE_PARAM(lightMinimum, PARAM_WORD),
+  PROFILE_PARAM(lightDayDuration, 0),
+  PROFILE_PARAM(silentMorning, 0),
+  PROFILE_PARAM(silentEvening, 0),
+  PROFILE_PARAM(humidMinimum, 0),
+  PROFILE_PARAM(humidMaximum, 0),
+  PROFILE_PARAM(zones[0].wateringDuration, PARAM_ZONE),
+  PROFILE_PARAM(zones[0].wateringSunnyPeriod, PARAM_ZONE),
+  PROFILE_PARAM(zones[0].wateringPeriod, PARAM_ZONE),
+  PROFILE_PARAM(zones[0].mistingDuration, PARAM_ZONE),
+  PROFILE_PARAM(zones[0].mistingSunnyPeriod, PARAM_ZONE),
+  PROFILE_PARAM(zones[0].mistingPeriod, PARAM_ZONE)
+};
+
+#define PROFILE_BIT(param) (1 << (param))
+
+static const Profile profileTable[PROFILES] PROGMEM = {
+  {"Manual", 0, 0, 0, 0, PROFILE_MANUAL},
+  {"Emergence", 0x0FFF & ~(PROFILE_BIT(P_HUMID_MINIMUM)|
+    PROFILE_BIT(P_HUMID_MAXIMUM)), 0, 0, 0, PROFILE_EMERGENCE},
+  {"Seedling", PROFILE_BIT(P_LIGHT_DURATION)|PROFILE_BIT(P_HUMID_MINIMUM)|
+    PROFILE_BIT(P_WATERING_DURATION)|PROFILE_BIT(P_MISTING_PERIOD),
+    10, 14, 4, PROFILE_VEGETATIVE},
+  {"Vegetative", PROFILE_BIT(P_LIGHT_DURATION), 14, 42, 14, PROFILE_FLOWERING},
+  {"Flowering", PROFILE_BIT(P_LIGHT_DURATION)|PROFILE_BIT(P_HUMID_MINIMUM)|
+    PROFILE_BIT(P_HUMID_MAXIMUM)|PROFILE_BIT(P_MISTING_PERIOD),
+    15, 56, 7, PROFILE_FLUSH},
+  {"Flush", PROFILE_BIT(P_LIGHT_DURATION)|PROFILE_BIT(P_HUMID_MINIMUM)|
+    PROFILE_BIT(P_HUMID_MAXIMUM)|PROFILE_BIT(P_WATERING_DURATION)|
+    PROFILE_BIT(P_MISTING_PERIOD), 19, 0, 0, PROFILE_FLUSH}
+};
+
+// Values of profiles in order of parameters
+static const uint16_t profileValues[] PROGMEM = {
+  // emergence
+  20000, 18, 0, 24, // lux, hours, silent hours
+  4, 2, 2, 5, 5, 5, // watering min, periods, misting sec, periods
+  // seedling
+  16, 60, 10, 30,
+  // vegetative
+  16,
+  // flowering
+  12, 40, 60, 90,
+  // flush
+  12, 40, 60, 25, 90
+};
+
+// Grow profiles over base settings. Active profile is switched by
+// pointer and its mask is cached, so reading of parameter is a mask
+// test and a popcount without copy of settings. Grow plan is kept in
+// settings, emergence is a temporary profile over it. Overlay of plan
+// keeps values which are computed elsewhere, it goes first.
+class Profiles
+{
+public:
+  Profiles(SettingsStruct &_base) : base(_base), active(profileTable),
+    mask(0), first(0), overlayMask(0), overlayValues(NULL) {}
+
+  // Use grow plan of settings
+  void begin() {
+    if(base.profile >= PROFILES) {
+      base.profile = PROFILE_MANUAL;
+    }
+    select(base.profile);
+  }
+
+  // Switch to profile, plan of settings is unchanged
+  void select(uint8_t _profile) {
+    if(_profile >= PROFILES) {
+      _profile = PROFILE_MANUAL;
+    }
+    active = &profileTable[_profile];
+    mask = pgm_read_word(&active->mask);
+    first = pgm_read_byte(&active->first);
+    overlayMask = 0;
+    #ifdef DEBUG_PROFILES
+      printf_P(PSTR("PROFILES: Info: Profile %d is selected.\n\r"), _profile);
+    #endif
+  }
+
+  // Active profile isn't the one of grow plan
+  bool isTemporary() {
+    return active != &profileTable[base.profile];
+  }
+
+  uint8_t index() {
+    return active - profileTable;
+  }
+
+  // Name in PROGMEM
+  static const char *name(uint8_t _profile) {
+    return profileTable[_profile].name;
+  }
+
+  // Values of slots by mask of parameters, till next select()
+  void overlay(uint16_t _mask, const uint16_t *_values) {
+    overlayMask = _mask;
+    overlayValues = _values;
+  }
+
+  // Value of parameter in active profile or base settings
+  uint16_t get(uint8_t _param, uint8_t _zone = 0) {
+    if(overlayMask & (1 << _param)) {
+      return overlayValues[slot(_param, _zone)];
+    }
+    return value(mask, first, _param, _zone);
+  }
+
+  // Value of parameter in any profile
+  uint16_t profileValue(uint8_t _profile, uint8_t _param, uint8_t _zone) {
+    return value(pgm_read_word(&profileTable[_profile].mask),
+      pgm_read_byte(&profileTable[_profile].first), _param, _zone);
+  }
+
+  // Index of parameter value for zone
+  static uint8_t slot(uint8_t _param, uint8_t _zone) {
+    return _param < PROFILE_PARAMS - ZONE_PARAMS ? _param :
+      _param + _zone*ZONE_PARAMS;
+  }
+
+private:
+  SettingsStruct &base;
+  const Profile *active;
+  uint16_t mask;
+  uint8_t first;
+  uint16_t overlayMask;
+  const uint16_t *overlayValues;
+
+  uint16_t value(uint16_t _mask, uint8_t _first, uint8_t _param,
+      uint8_t _zone) {
+    uint16_t bit = 1 << _param;
+    if(_mask & bit) {
+      return pgm_read_word(&profileValues[_first +
+        __builtin_popcount(_mask & (bit - 1))]);
+    }
+    uint8_t flags = pgm_read_byte(&profileParams[_param].flags);
+    const uint8_t *value = (const uint8_t *)&base +
+      pgm_read_byte(&profileParams[_param].offset);
+    if(flags & PARAM_ZONE) {
+      value += _zone*sizeof(ZoneConfig);
+    }
+    return (flags & PARAM_WORD) ? *(const uint16_t *)value : *value;
+  }
+};
+
+#endif // __PROFILES_H__
@@ -117,7 +117,7 @@ DateTime::DateTime (const char* date, const char* time) {
     yOff = conv2d(date + 9);
     // Jan Feb Mar Apr May Jun Jul Aug Sep Oct Nov Dec 
     switch (date[0]) {
-        case 'J': m = date[1] == 'a' ? 1 : m = date[2] == 'n' ? 6 : 7; break;
+        case 'J': m = date[1] == 'a' ? 1 : date[2] == 'n' ? 6 : 7; break;
         case 'F': m = 2; break;
         case 'A': m = date[2] == 'r' ? 4 : 8; break;
         case 'M': m = date[2] == 'r' ? 3 : 5; break;
@@ -142,7 +142,7 @@ DateTime::DateTime (const __FlashStringHelper* date, const __FlashStringHelper*
     yOff = conv2d(buff + 9);
     // Jan Feb Mar Apr May Jun Jul Aug Sep Oct Nov Dec
     switch (buff[0]) {
-        case 'J': m = buff[1] == 'a' ? 1 : m = buff[2] == 'n' ? 6 : 7; break;
+        case 'J': m = buff[1] == 'a' ? 1 : buff[2] == 'n' ? 6 : 7; break;
         case 'F': m = 2; break;
         case 'A': m = buff[2] == 'r' ? 4 : 8; break;
         case 'M': m = buff[2] == 'r' ? 3 : 5; break;
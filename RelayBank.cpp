@@ -0,0 +1,144 @@
+#include "RelayBank.h"
+#if RELAY_SHIFT_BYTES > 0
+#include <SPI.h>
+#endif
+
+RelayBank::RelayBank(const RelayConfig *table, uint8_t count)
+{
+  _table = table;
+  _count = min(count, RELAY_MAX);
+  _state = 0;
+  _wasOn = 0;
+  memset(_limits, 0xFF, sizeof(_limits));
+}
+
+void RelayBank::begin(void)
+{
+#if RELAY_SHIFT_BYTES > 0
+  // outputs of chain are off
+  for (uint8_t i = 0; i < RELAY_SHIFT_BYTES; i++)
+    _shift[i] = 0;
+  RELAY_LATCH_PORT &= ~_BV(RELAY_LATCH_BIT);
+  // DDR register is before PORT one
+  *(&RELAY_LATCH_PORT - 1) |= _BV(RELAY_LATCH_BIT);
+  SPI.begin();
+#endif
+  for (uint8_t i = 0; i < _count; i++) {
+    _write(i, false);
+    uint8_t port = pgm_read_byte(&_table[i].port);
+    if (port != RELAY_SHIFT) {
+      // set level first, then make it output
+      volatile uint8_t *ddr = &_MMIO_BYTE(port - 1);
+      uint8_t oldSREG = SREG;
+      cli();
+      *ddr |= _BV(pgm_read_byte(&_table[i].bit));
+      SREG = oldSREG;
+    }
+  }
+#if RELAY_SHIFT_BYTES > 0
+  _latch();
+#endif
+}
+
+void RelayBank::limit(uint8_t group, uint8_t maximum)
+{
+  if (group > 0 && group < RELAY_GROUPS)
+    _limits[group] = maximum;
+}
+
+bool RelayBank::set(uint8_t relay, bool on)
+{
+  if (relay >= _count)
+    return false;
+  uint32_t bit = (uint32_t)1 << relay;
+  if (on == ((_state & bit) != 0))
+    return true;
+
+  if (on) {
+    uint8_t group = pgm_read_byte(&_table[relay].group);
+    if (group > 0 && _groupCount(group) >= _limits[group])
+      return false;
+    _state |= bit;
+    _wasOn |= bit;
+  } else {
+    _state &= ~bit;
+  }
+  _write(relay, on);
+#if RELAY_SHIFT_BYTES > 0
+  if (pgm_read_byte(&_table[relay].port) == RELAY_SHIFT)
+    _latch();
+#endif
+  return true;
+}
+
+bool RelayBank::isOn(uint8_t relay)
+{
+  if (relay >= _count)
+    return false;
+  return (_state >> relay) & 1;
+}
+
+uint32_t RelayBank::state(void)
+{
+  return _state;
+}
+
+uint32_t RelayBank::wasOn(void)
+{
+  uint32_t bits = _wasOn;
+  // relays which stay on are on in the next period too
+  _wasOn = _state;
+  return bits;
+}
+
+uint8_t RelayBank::_groupCount(uint8_t group)
+{
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    if (isOn(i) && pgm_read_byte(&_table[i].group) == group)
+      count++;
+  }
+  return count;
+}
+
+void RelayBank::_write(uint8_t relay, bool on)
+{
+  uint8_t port = pgm_read_byte(&_table[relay].port);
+  uint8_t mask = _BV(pgm_read_byte(&_table[relay].bit));
+  bool high = on != pgm_read_byte(&_table[relay].activeLow);
+
+  if (port == RELAY_SHIFT) {
+#if RELAY_SHIFT_BYTES > 0
+    uint8_t *shift = &_shift[pgm_read_byte(&_table[relay].bit) >> 3];
+    mask = _BV(pgm_read_byte(&_table[relay].bit) & 7);
+    if (high)
+      *shift |= mask;
+    else
+      *shift &= ~mask;
+#endif
+    return;
+  }
+  // other pins of the port can be changed by interrupts
+  volatile uint8_t *out = &_MMIO_BYTE(port);
+  uint8_t oldSREG = SREG;
+  cli();
+  if (high)
+    *out |= mask;
+  else
+    *out &= ~mask;
+  SREG = oldSREG;
+}
+
+#if RELAY_SHIFT_BYTES > 0
+void RelayBank::_latch(void)
+{
+  // the last chip of chain goes first
+  for (int8_t i = RELAY_SHIFT_BYTES-1; i >= 0; i--)
+    SPI.transfer(_shift[i]);
+  uint8_t oldSREG = SREG;
+  cli();
+  RELAY_LATCH_PORT |= _BV(RELAY_LATCH_BIT);
+  RELAY_LATCH_PORT &= ~_BV(RELAY_LATCH_BIT);
+  SREG = oldSREG;
+}
+#endif
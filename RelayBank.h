@@ -0,0 +1,79 @@
+#ifndef RelayBank_h
+#define RelayBank_h
+
+#include <Arduino.h>
+
+// Relay outputs from a table in flash. Direct outputs are switched by
+// writing the PORT register, outputs of 74HC595 shift registers are
+// updated by one SPI transfer of the chain and a latch pulse.
+
+// Bytes (74HC595 chips) in shift register chain, 0 disables it
+#ifndef RELAY_SHIFT_BYTES
+#define RELAY_SHIFT_BYTES 0
+#endif
+
+// Latch (RCLK) of shift register chain, pin 6 is PORTD bit 6
+#ifndef RELAY_LATCH_PORT
+#define RELAY_LATCH_PORT PORTD
+#define RELAY_LATCH_BIT PD6
+#endif
+
+// Interlock groups, group 0 has no limit
+#define RELAY_GROUPS 4
+
+// Maximum of relays
+#define RELAY_MAX 32
+
+// Port of outputs which are in shift register chain
+#define RELAY_SHIFT 0
+
+// Output of relay: I/O address of PORT register (_SFR_MEM_ADDR(PORTD))
+// and bit, or RELAY_SHIFT and output number in the chain.
+struct RelayConfig
+{
+  uint8_t port;
+  uint8_t bit;
+  uint8_t group; // interlock group
+  bool activeLow; // relay is on by low level
+};
+
+class RelayBank
+{
+  public:
+    RelayBank(const RelayConfig *table, uint8_t count);
+
+    // Switch all relays off and configure outputs
+    void begin(void);
+
+    // Maximum of relays of group which are on at the same time
+    void limit(uint8_t group, uint8_t maximum);
+
+    // Returns false if relay is unknown or interlock doesn't allow it
+    bool set(uint8_t relay, bool on);
+
+    // Returns false if relay is unknown
+    bool isOn(uint8_t relay);
+
+    // Bit per relay which is on
+    uint32_t state(void);
+
+    // Bit per relay which was on since the previous call, short runs
+    // between calls too
+    uint32_t wasOn(void);
+
+  private:
+    const RelayConfig *_table;
+    uint8_t _count;
+    uint32_t _state;
+    uint32_t _wasOn;
+    uint8_t _limits[RELAY_GROUPS];
+#if RELAY_SHIFT_BYTES > 0
+    uint8_t _shift[RELAY_SHIFT_BYTES];
+    void _latch(void);
+#endif
+
+    uint8_t _groupCount(uint8_t group);
+    void _write(uint8_t relay, bool on);
+};
+
+#endif
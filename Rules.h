@@ -0,0 +1,171 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+#include "Alarms.h"
+
+//#define DEBUG_RULES
+
+// Targets of rules, every target gets the value of its first matching
+// rule or 0 if none matches
+static const uint8_t RULE_NONE = 0; // unused record
+static const uint8_t RULE_MODE = 1; // work mode of zones
+static const uint8_t RULE_LAMP = 2; // lamp relay, 1 is on
+static const uint8_t RULE_DAWN = 3; // sunrise is watched, 1 is on
+static const uint8_t RULE_TARGETS = 4;
+// Work modes
+static const uint8_t MODE_NORMAL = 0; // normal periods
+static const uint8_t MODE_SUNNY = 1; // sunny periods
+static const uint8_t MODE_NIGHT = 2; // silent, no work
+// Input flags which compare states with settings
+static const uint8_t IN_SILENT_DAY = 1; // between silent morning and evening
+static const uint8_t IN_LIGHT_DAY = 2; // light day of lamp
+static const uint8_t IN_AIR_COLD = 4; // air at or below minimum
+static const uint8_t IN_BRIGHT = 8; // light above minimum
+// Alarm condition: code has to be active, with RULE_NOT inactive.
+// RULE_ERRORS stands for any error.
+static const uint8_t RULE_ANY = NO_ALARM;
+static const uint8_t RULE_ERRORS = 0x40;
+static const uint8_t RULE_NOT = 0x80;
+// Band which takes any value
+static const uint16_t LUX_ANY = 0xFFFF;
+static const int8_t TEMP_ANY_MIN = -128;
+static const int8_t TEMP_ANY_MAX = 127;
+// Header of EEPROM overlay
+static const char RULES_ID = 'R';
+
+// Rule maps conditions to value of target. Hour window is [from, to)
+// and wraps over midnight, equal hours take any hour. Lux band is
+// [min, max), air temperature band is [min, max].
+struct Rule {
+  uint8_t target, value;
+  uint8_t when, unless; // input flags which have to be set and clear
+  uint8_t hourFrom, hourTo;
+  uint16_t luxMin, luxMax;
+  int8_t tempMin, tempMax;
+  uint8_t alarm;
+};
+
+// Inputs of rules, they are evaluated again only if it changes
+struct RuleInput {
+  uint32_t alarms; // active alarms
+  uint16_t lux;
+  int8_t airTemp;
+  uint8_t flags, hour;
+
+  bool operator==(const RuleInput &_other) const {
+    return alarms == _other.alarms && lux == _other.lux &&
+      airTemp == _other.airTemp && flags == _other.flags &&
+      hour == _other.hour;
+  }
+};
+
+// Table of rules in PROGMEM with optional overlay in EEPROM. Overlay
+// rules go before the table, so they take priority and operators can
+// change policy without reflashing. Overlay is RULES_ID, count and
+// count of Rule records. A pass over rules stops when every target
+// has got its value, so cost is bounded by size of table.
+class RuleTable
+{
+public:
+  uint8_t results[RULE_TARGETS];
+
+  RuleTable(const Rule *_table, uint8_t _count) : table(_table),
+    count(_count), overlayAddress(0), overlayCount(0), evaluated(false) {}
+
+  // Use overlay if EEPROM area keeps a valid one
+  void load(uint16_t _address, uint16_t _size) {
+    overlayAddress = _address + 2;
+    overlayCount = 0;
+    if(eeprom_read_byte((uint8_t*)(uintptr_t)_address) != RULES_ID) {
+      return;
+    }
+    uint8_t overlay = eeprom_read_byte((uint8_t*)(uintptr_t)_address + 1);
+    if(overlay <= (_size - 2)/sizeof(Rule)) {
+      overlayCount = overlay;
+    }
+    #ifdef DEBUG_RULES
+      printf_P(PSTR("RULES: Info: %d rules of EEPROM overlay.\n\r"), overlay);
+    #endif
+  }
+
+  // Returns true if inputs have changed and rules were evaluated
+  bool update(const RuleInput &_input) {
+    if(evaluated && _input == last) {
+      return false;
+    }
+    last = _input;
+    evaluated = true;
+    memset(results, 0, sizeof(results));
+    uint8_t pending = ((1 << RULE_TARGETS) - 1) & ~(1 << RULE_NONE);
+    for(uint8_t i=0; i<overlayCount+count && pending; i++) {
+      Rule rule;
+      read(i, &rule);
+      if(rule.target >= RULE_TARGETS ||
+          (pending & (1 << rule.target)) == 0 ||
+          matches(rule, _input) == false) {
+        continue;
+      }
+      results[rule.target] = rule.value;
+      pending &= ~(1 << rule.target);
+    }
+    #ifdef DEBUG_RULES
+      printf_P(PSTR("RULES: Info: Mode %d, lamp %d, dawn %d.\n\r"),
+        results[RULE_MODE], results[RULE_LAMP], results[RULE_DAWN]);
+    #endif
+    return true;
+  }
+
+private:
+  const Rule *table;
+  uint8_t count;
+  uint16_t overlayAddress;
+  uint8_t overlayCount;
+  bool evaluated;
+  RuleInput last;
+
+  void read(uint8_t _index, Rule *_rule) {
+    if(_index < overlayCount) {
+      eeprom_read_block(_rule, (const void*)(uintptr_t)(overlayAddress +
+        _index*sizeof(Rule)), sizeof(Rule));
+    } else {
+      memcpy_P(_rule, &table[_index - overlayCount], sizeof(Rule));
+    }
+  }
+
+  static bool matches(const Rule &_rule, const RuleInput &_input) {
+    if((_input.flags & _rule.when) != _rule.when ||
+        (_input.flags & _rule.unless) != 0) {
+      return false;
+    }
+    if(_rule.hourFrom != _rule.hourTo) {
+      bool inside = _rule.hourFrom < _rule.hourTo ?
+        _rule.hourFrom <= _input.hour && _input.hour < _rule.hourTo :
+        _rule.hourFrom <= _input.hour || _input.hour < _rule.hourTo;
+      if(inside == false) {
+        return false;
+      }
+    }
+    if(_input.lux < _rule.luxMin ||
+        (_rule.luxMax != LUX_ANY && _input.lux >= _rule.luxMax)) {
+      return false;
+    }
+    if(_input.airTemp < _rule.tempMin || _input.airTemp > _rule.tempMax) {
+      return false;
+    }
+    return alarmMatches(_rule.alarm, _input.alarms);
+  }
+
+  static bool alarmMatches(uint8_t _alarm, uint32_t _active) {
+    if(_alarm == RULE_ANY) {
+      return true;
+    }
+    uint8_t code = _alarm & ~RULE_NOT;
+    bool active = code == RULE_ERRORS ?
+      (_active & ALARM_ERRORS) != 0 : (_active & ALARM_BIT(code)) != 0;
+    return (_alarm & RULE_NOT) ? active == false : active;
+  }
+};
+
+#endif // __RULES_H__
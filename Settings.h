@@ -3,40 +3,39 @@
 #define SETTINGS_H
 
 #include <avr/eeprom.h>
+#include "SettingsStruct.h"
 
 //#define DEBUG_EEPROM
 
 static const uint8_t EEPROM_SIZE = 255;
+// DS18B20 ROM table is stored after settings
+static const uint16_t DS18B20_EEPROM_ADDRESS = EEPROM_SIZE+1;
+// Overlay of control rules is stored after the ROM table
+static const uint16_t RULES_EEPROM_ADDRESS = 320;
+static const uint16_t RULES_EEPROM_SIZE = 64;
+// Long-term history log takes the rest of EEPROM
+static const uint16_t LOG_EEPROM_ADDRESS = RULES_EEPROM_ADDRESS+RULES_EEPROM_SIZE;
+static const uint16_t LOG_EEPROM_SIZE = E2END+1-LOG_EEPROM_ADDRESS;
 //#define EEPROM_OFFSET
 // prevent burn memory
 static const uint8_t MAX_WRITES = 20;
 // Declare EEPROM values
-#define SETTINGS_ID  "$"
-// Declare structure and default settings
-struct SettingsStruct {
-  uint8_t wateringDuration, wateringSunnyPeriod, wateringPeriod;
-  uint8_t mistingDuration, mistingSunnyPeriod, mistingPeriod;
-  uint16_t lightMinimum, lightDayStart; uint8_t lightDayDuration;
-  uint8_t humidMinimum, humidMaximum; 
-  uint8_t airTempMinimum, airTempMaximum, subsTempMinimum;
-  uint8_t silentEvening, silentMorning, emergenceDuration;
-  char id[2];
-  uint8_t c_celcium[8], c_heart[8], c_humidity[8];
-  uint8_t c_temp[8], c_flower[8], c_lamp[8];
-  uint8_t c_up[8], c_down[8];
-} settings = {
-  15, 60, 90,
-  3, 120, 60,
+#define SETTINGS_ID  "'"
+// Declare default settings
+SettingsStruct settings = {
+  {{15, 60, 90, 3, 120, 60}}, // other zones are off
   1000, 360, 14,
   45, 75,
   18, 30, 16,
   23, 7, 30,
+  0, 0,
+  {900, 700, 500, 300, 100}, {900, 700, 500, 300, 100},
   SETTINGS_ID,
   {24, 24, 3, 4, 4, 4, 3, 0}, {0, 10, 31, 31, 14, 4, 0, 0}, 
   {4, 10, 10, 17, 17, 17, 14, 0}, {4, 10, 10, 14, 31, 31, 14, 0},
   {14, 27, 21, 14, 4, 12, 4, 0}, {14, 17, 17, 17, 14, 14, 4, 0},
   {4, 14, 21, 4, 4, 4, 4, 0}, {4, 4, 4, 4, 21, 14, 4, 0}
-}, backup;
+};
 
 
 class EEPROM 
@@ -124,19 +123,19 @@ class EEPROM
     uint16_t writes_count;
 
     template <class T> void readBlock(uint16_t _address, const T& _value) {
-       eeprom_read_block((void*)&_value, (const void*)_address, sizeof(_value));
+       eeprom_read_block((void*)&_value, (const void*)(uintptr_t)_address, sizeof(_value));
     }
 
     template <class T> uint8_t updateBlock(uint16_t _address, T& _value) {
       uint8_t writeCount = 0, skipCount = 0;
       const uint8_t* bytePointer = (const uint8_t*)(void*)&_value;
       for(uint8_t i = 0; i < sizeof(_value); i++) {
-        if (eeprom_read_byte((uint8_t*)_address) != *bytePointer) {
+        if (eeprom_read_byte((uint8_t*)(uintptr_t)_address) != *bytePointer) {
           #ifdef DEBUG_EEPROM
             printf_P(PSTR("writing: %d\n\r"), *bytePointer);
           #endif
           //do the actual EEPROM writing
-          eeprom_write_byte((uint8_t*)_address, *bytePointer);
+          eeprom_write_byte((uint8_t*)(uintptr_t)_address, *bytePointer);
           writeCount++; 
         } else {
           skipCount++;
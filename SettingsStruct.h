@@ -0,0 +1,23 @@
+#ifndef SETTINGSSTRUCT_H
+#define SETTINGSSTRUCT_H
+
+#include "TankLevel.h"
+#include "Zone.h"
+
+// Structure of settings, defaults and EEPROM storage are in Settings.h.
+// Change SETTINGS_ID there together with the layout.
+struct SettingsStruct {
+  ZoneConfig zones[ZONES];
+  uint16_t lightMinimum, lightDayStart; uint8_t lightDayDuration;
+  uint8_t humidMinimum, humidMaximum; 
+  uint8_t airTempMinimum, airTempMaximum, subsTempMinimum;
+  uint8_t silentEvening, silentMorning, emergenceDuration;
+  uint8_t profile; uint16_t profileDay; // grow plan and its start day
+  uint16_t substrateLevels[LEVEL_POINTS], waterLevels[LEVEL_POINTS];
+  char id[2];
+  uint8_t c_celcium[8], c_heart[8], c_humidity[8];
+  uint8_t c_temp[8], c_flower[8], c_lamp[8];
+  uint8_t c_up[8], c_down[8];
+};
+
+#endif // __SETTINGSSTRUCT_H__
@@ -17,7 +17,7 @@ class SimpleMap
     /**
      * Initialize map
      */
-    SimpleMap() {
+    SimpleMap() : nil() {
       currentIndex = 0;
     }
 
@@ -0,0 +1,57 @@
+#ifndef STATES_H
+#define STATES_H
+
+#include "SimpleMap.h"
+#include "Alarms.h"
+
+// Keys of state map and alarm codes. They are shared by the menu and
+// the controller, instances are declared in LcdMenu.h.
+
+// Declare state map type
+typedef SimpleMap<uint8_t, uint16_t, 12> States;
+// Define state map keys constants
+static const uint8_t HUMIDITY = 1; // air humidity
+static const uint8_t AIR_TEMP = 2;
+static const uint8_t COMPUTER_TEMP = 3; // temperature inside
+static const uint8_t SUBSTRATE_TEMP = 4;
+static const uint8_t LIGHT = 5; // light intensivity
+static const uint8_t PUMP_MISTING = 6;
+static const uint8_t PUMP_WATERING = 7;
+static const uint8_t LAMP = 8;
+static const uint8_t ALARMS = 9; // telemetry of alarm set
+static const uint8_t WATERING = 16;
+static const uint8_t MISTING = 17;
+static const uint8_t SUBSTRATE_LEVEL = 18; // percent of fill
+static const uint8_t WATER_LEVEL = 19;
+// Define warning alarms in order of priority
+static const uint8_t NO_WARNING = NO_ALARM;
+static const uint8_t INFO_SUBSTRATE_FULL = 1;
+static const uint8_t INFO_SUBSTRATE_DELIVERED = 2;
+static const uint8_t WARNING_REFILL_WATER = 3;
+static const uint8_t WARNING_REFILL_SUBSTRATE = 4;
+static const uint8_t WARNING_MISTING = 5;
+static const uint8_t WARNING_WATERING = 6;
+static const uint8_t WARNING_SUBSTRATE_LOW = 7;
+static const uint8_t WARNING_AIR_HOT = 8;
+static const uint8_t WARNING_AIR_COLD = 9;
+static const uint8_t WARNING_SUBSTRATE_COLD = 10;
+static const uint8_t WARNING_NO_WATER = 11;
+// Define error alarms in order of priority
+static const uint8_t NO_ERROR = NO_ALARM;
+static const uint8_t ERROR_DS18B20 = 16;
+static const uint8_t ERROR_BH1750 = 17;
+static const uint8_t ERROR_DHT = 18;
+static const uint8_t ERROR_CLOCK = 19;
+static const uint8_t ERROR_EEPROM = 20;
+static const uint8_t ERROR_NO_SUBSTRATE = 21;
+static const uint8_t ERROR_LOW_MEMORY = 22;
+// Intermittent faults are kept on screen till button press
+static const uint32_t LATCHING_ALARMS = ALARM_BIT(ERROR_DS18B20) | 
+  ALARM_BIT(ERROR_BH1750) | ALARM_BIT(ERROR_DHT) | 
+  ALARM_BIT(ERROR_NO_SUBSTRATE);
+// Years of set clock, ERROR_CLOCK is raised out of them. Days from 2000
+// of the crop calendar are valid till 2099.
+static const uint16_t CLOCK_YEAR_MINIMUM = 2014;
+static const uint16_t CLOCK_YEAR_MAXIMUM = 2099;
+
+#endif // __STATES_H__
@@ -0,0 +1,81 @@
+#ifndef TANKLEVEL_H
+#define TANKLEVEL_H
+
+// Calibration points at 0, 25, 50, 75 and 100 percent of fill
+static const uint8_t LEVEL_POINTS = 5;
+static const uint16_t LEVEL_STEP = 10000/(LEVEL_POINTS-1);
+// Unknown time to empty
+static const uint16_t NO_ESTIMATE = 0xFFFF;
+
+class TankLevel
+{
+public:
+  // Fill in 0.01% from raw value by calibration table of raw values,
+  // the table can be rising or falling
+  static uint16_t fill(uint16_t _raw, const uint16_t* _table) {
+    bool falling = _table[0] > _table[LEVEL_POINTS-1];
+    for(uint8_t i = 0; i < LEVEL_POINTS-1; i++) {
+      uint16_t from = _table[i], to = _table[i+1];
+      bool before = falling ? _raw >= from : _raw <= from;
+      if(before)
+        return i*LEVEL_STEP;
+      bool inside = falling ? _raw > to : _raw < to;
+      if(inside) {
+        uint16_t offset = falling ? from-_raw : _raw-from;
+        uint16_t range = falling ? from-to : to-from;
+        return i*LEVEL_STEP + (uint32_t)offset*LEVEL_STEP/range;
+      }
+    }
+    return 10000;
+  }
+
+  // Update level, call it every minute. Returns fill in percent.
+  uint8_t update(uint16_t _raw, const uint16_t* _table) {
+    level = fill(_raw, _table);
+    if(minutes == 0) {
+      hourLevel = level;
+    }
+    // consumption for the last hour
+    if(++minutes > 60) {
+      minutes = 1;
+      if(level > hourLevel) {
+        // tank was refilled
+        hourLevel = level;
+        return percent();
+      }
+      uint32_t used = hourLevel-level;
+      // rolling average of 4 hours in 1/16 units, so small consumption
+      // counts and the average decays to zero
+      rate = rate == 0 ? used << 4 : rate - (rate >> 2) + (used << 2);
+      hourLevel = level;
+    }
+    return percent();
+  }
+
+  // Fill in percent
+  uint8_t percent() {
+    return level/100;
+  }
+
+  // Consumption in 0.01% per hour
+  uint16_t consumption() {
+    return rate >> 4;
+  }
+
+  // Predicted hours to empty tank
+  uint16_t hoursLeft() {
+    uint16_t used = consumption();
+    if(used == 0)
+      return NO_ESTIMATE;
+    return level/used;
+  }
+
+private:
+  uint16_t level;
+  uint16_t hourLevel;
+  uint32_t rate; // 1/16 of 0.01% per hour
+  uint8_t minutes;
+
+};
+
+#endif // __TANKLEVEL_H__
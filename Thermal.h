@@ -0,0 +1,58 @@
+#ifndef THERMAL_H
+#define THERMAL_H
+
+//#define DEBUG_THERMAL
+
+// Thermal levels of computer enclosure, every level keeps throttling of
+// lower ones
+static const uint8_t THERMAL_NORMAL = 0;
+static const uint8_t THERMAL_WARM = 1; // backlight off, slower LCD refresh
+static const uint8_t THERMAL_HOT = 2; // lamp is shed, light sensor deferred
+static const uint8_t THERMAL_CRITICAL = 3; // misting is shed, short naps
+// Temperatures to enter level, C
+static const uint8_t THERMAL_WARM_TEMP = 40;
+static const uint8_t THERMAL_HOT_TEMP = 45;
+static const uint8_t THERMAL_CRITICAL_TEMP = 50;
+// Level is left when temperature falls this much below its entry
+static const uint8_t THERMAL_HYSTERESIS = 3;
+
+// Graded thermal state machine. Level goes up as soon as temperature
+// reaches entry of the next one and goes down only after it cools by
+// hysteresis below entry of the current one, so loads don't toggle
+// around a threshold.
+class ThermalGuard
+{
+public:
+  uint8_t level;
+
+  // Returns true if level is changed
+  bool update(uint8_t _temp) {
+    uint8_t last = level;
+    while(level < THERMAL_CRITICAL && _temp >= entry(level+1)) {
+      level++;
+    }
+    while(level > THERMAL_NORMAL &&
+        _temp + THERMAL_HYSTERESIS <= entry(level)) {
+      level--;
+    }
+    #ifdef DEBUG_THERMAL
+      if(level != last)
+        printf_P(PSTR("THERMAL: Info: Computer %dC, level %d->%d.\n\r"),
+          _temp, last, level);
+    #endif
+    return level != last;
+  }
+
+private:
+  static uint8_t entry(uint8_t _level) {
+    switch(_level) {
+      case THERMAL_WARM:
+        return THERMAL_WARM_TEMP;
+      case THERMAL_HOT:
+        return THERMAL_HOT_TEMP;
+    }
+    return THERMAL_CRITICAL_TEMP;
+  }
+};
+
+#endif // __THERMAL_H__
@@ -0,0 +1,166 @@
+#include "TicklessIdle.h"
+#include <avr/sleep.h>
+
+// Timer1 runs with prescaler 8
+#define TICKS_PER_MS (clockCyclesPerMicrosecond() * 1000L / 8)
+// Timer0 of the core has prescaler 64
+#define TICKS_PER_TIMER0_TICK 8
+#define TICKS_PER_OVERFLOW (TICKS_PER_TIMER0_TICK * 256)
+// Longest step between compare matches, below Timer1 period
+#define IDLE_STEP 0xF000
+// Rest of sleep which isn't worth to sleep again, ticks
+#define IDLE_GUARD 64
+
+// Counters of the core, wiring.c
+extern volatile unsigned long timer0_millis;
+extern volatile unsigned long timer0_overflow_count;
+
+TicklessIdle *TicklessIdle::active = NULL;
+
+TicklessIdle::TicklessIdle(void)
+{
+  _span = IDLE_MAX_SLEEP;
+  _woken = false;
+  _msRemainder = 0;
+  _tickRemainder = 0;
+  _sleepTime = 0;
+  _sleepRemainder = 0;
+  _sleeps = 0;
+  _statsStart = 0;
+}
+
+bool TicklessIdle::attach(uint8_t pin)
+{
+  if (pin < A0 || pin > A5)
+    return false;
+  active = this;
+  PCMSK1 |= _BV(pin - A0);
+  PCIFR = _BV(PCIF1);
+  PCICR |= _BV(PCIE1);
+  return true;
+}
+
+void TicklessIdle::begin(void)
+{
+  active = this;
+  // normal mode, prescaler 8, the same as OneWireAsync uses
+  if ((TCCR1B & (_BV(CS12) | _BV(CS11) | _BV(CS10))) == 0) {
+    TCCR1A = 0;
+    TCCR1B = _BV(CS11);
+  }
+  _statsStart = millis();
+}
+
+void TicklessIdle::wakeIn(uint16_t ms)
+{
+  if (ms < _span)
+    _span = ms;
+}
+
+void TicklessIdle::hold(void)
+{
+  _span = 0;
+}
+
+void TicklessIdle::sleep(void)
+{
+  uint16_t span = _span;
+  _span = IDLE_MAX_SLEEP;
+  if (span < IDLE_MIN_SLEEP)
+    return;
+
+  int32_t ticks = (int32_t)span * TICKS_PER_MS;
+  int32_t elapsed = 0;
+  uint32_t asleep = _sleepRemainder;
+  _woken = false;
+  _sleeps++;
+  set_sleep_mode(SLEEP_MODE_IDLE);
+
+  // Timer1 registers are shared with the 1-Wire interrupt
+  cli();
+  uint16_t last = TCNT1;
+  uint8_t phase = TCNT0;
+  // stop the tick, Timer0 counts on
+  TIMSK0 &= ~_BV(TOIE0);
+  TIFR1 = _BV(OCF1B);
+  TIMSK1 |= _BV(OCIE1B);
+  for (;;) {
+    uint16_t now = TCNT1;
+    elapsed += (uint16_t)(now - last);
+    last = now;
+    if (_woken || elapsed + IDLE_GUARD >= ticks)
+      break;
+    int32_t left = ticks - elapsed;
+    OCR1B = now + (left > IDLE_STEP ? IDLE_STEP : (uint16_t)left);
+    sleep_enable();
+    uint16_t before = TCNT1;
+    sei();
+    sleep_cpu();
+    // the waking interrupt was served before
+    asleep += (uint16_t)(TCNT1 - before);
+    sleep_disable();
+    cli();
+  }
+  TIMSK1 &= ~_BV(OCIE1B);
+  // overflows in sleep are measured by Timer1, drop the pending one
+  TIFR0 = _BV(TOV0);
+  TIMSK0 |= _BV(TOIE0);
+  // Timer0 didn't count the part of its period before the sleep and
+  // will count again the part after the last overflow
+  elapsed += ((int16_t)phase - TCNT0) * TICKS_PER_TIMER0_TICK;
+  sei();
+
+  _sleepTime += asleep / TICKS_PER_MS;
+  _sleepRemainder = asleep % TICKS_PER_MS;
+
+  // pin change can wake it at once
+  if (elapsed > 0)
+    _advance(elapsed);
+}
+
+void TicklessIdle::compensate(uint16_t ms)
+{
+  _advance((uint32_t)ms * TICKS_PER_MS);
+  _sleepTime += ms;
+}
+
+void TicklessIdle::stats(uint8_t *percent, uint16_t *sleeps)
+{
+  unsigned long now = millis();
+  unsigned long total = now - _statsStart;
+  *percent = total == 0 ? 0 : min(_sleepTime * 100 / total, 100);
+  *sleeps = _sleeps;
+  _statsStart = now;
+  _sleepTime = 0;
+  _sleeps = 0;
+}
+
+void TicklessIdle::handleInterrupt(void)
+{
+  _woken = true;
+}
+
+void TicklessIdle::_advance(uint32_t ticks)
+{
+  uint32_t ms = ticks + _msRemainder;
+  uint32_t overflows = ticks + _tickRemainder;
+  _msRemainder = ms % TICKS_PER_MS;
+  _tickRemainder = overflows % TICKS_PER_OVERFLOW;
+  ms /= TICKS_PER_MS;
+  overflows /= TICKS_PER_OVERFLOW;
+
+  uint8_t oldSREG = SREG;
+  cli();
+  timer0_millis += ms;
+  timer0_overflow_count += overflows;
+  SREG = oldSREG;
+}
+
+// Wakes the MCU only
+EMPTY_INTERRUPT(TIMER1_COMPB_vect);
+
+ISR(PCINT1_vect)
+{
+  if (TicklessIdle::active)
+    TicklessIdle::active->handleInterrupt();
+}
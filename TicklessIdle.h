@@ -0,0 +1,56 @@
+#ifndef TicklessIdle_h
+#define TicklessIdle_h
+
+#include <Arduino.h>
+
+// Sleep of the MCU between deadlines of tasks. Every loop pass tasks
+// tell when they need the CPU again, then sleep() puts the MCU into
+// idle mode till the earliest deadline. The Timer0 tick is stopped
+// meanwhile, Timer1 compare B wakes the MCU and measures the sleep,
+// which is added to millis() after wake up. Pin change of attached
+// pins ends the sleep at once. Other interrupts (ADC window, 1-Wire,
+// serial, uptime) are served and the MCU goes on sleeping. Statistics
+// count only time in sleep_cpu(), the waking interrupt included, not
+// the time of other interrupts and of the loop between them.
+
+// Longest sleep, ms
+#define IDLE_MAX_SLEEP 1000
+// Shorter sleep doesn't pay for stopping of the tick, ms
+#define IDLE_MIN_SLEEP 2
+
+class TicklessIdle
+{
+  public:
+    TicklessIdle(void);
+    // Wake on change of pin, A0-A5 only. Returns false for other pins.
+    bool attach(uint8_t pin);
+    // Start Timer1 if it isn't running yet
+    void begin(void);
+    // Task needs the CPU within ms
+    void wakeIn(uint16_t ms);
+    // Task needs polling, don't sleep on this pass
+    void hold(void);
+    // Sleep till the earliest deadline of this pass
+    void sleep(void);
+    // Add time of power down, which stops all timers, to millis()
+    void compensate(uint16_t ms);
+    // Percent of time in sleep and count of sleeps since last call
+    void stats(uint8_t *percent, uint16_t *sleeps);
+    // Pin change interrupt handler
+    void handleInterrupt(void);
+    static TicklessIdle *active;
+
+  private:
+    uint16_t _span; // ms till the earliest deadline
+    volatile bool _woken;
+    uint16_t _msRemainder; // Timer1 ticks under 1 ms
+    uint16_t _tickRemainder; // Timer1 ticks under Timer0 overflow
+    uint32_t _sleepTime; // ms
+    uint16_t _sleepRemainder; // Timer1 ticks of sleep under 1 ms
+    uint16_t _sleeps;
+    unsigned long _statsStart;
+
+    void _advance(uint32_t ticks);
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include "Uptime.h"
+
+#define TICKS_PER_OVERFLOW 0x10000UL
+
+Uptime::Uptime(void)
+{
+  _overflows = 0;
+  _fraction = 0;
+  _seconds = 0;
+  _minutes = 0;
+  _minuteSeconds = 0;
+  _carry = 0;
+}
+
+void Uptime::begin(void)
+{
+  // normal mode, prescaler 8, the same as OneWireAsync uses
+  if ((TCCR1B & (_BV(CS12) | _BV(CS11) | _BV(CS10))) == 0) {
+    TCCR1A = 0;
+    TCCR1B = _BV(CS11);
+  }
+  uint8_t oldSREG = SREG;
+  cli();
+  TIFR1 = _BV(TOV1);
+  TIMSK1 |= _BV(TOIE1);
+  SREG = oldSREG;
+}
+
+uint64_t Uptime::ticks(void)
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  uint32_t overflows = _overflows;
+  uint16_t count = TCNT1;
+  // overflow which isn't served yet
+  if ((TIFR1 & _BV(TOV1)) && count < 0x8000)
+    overflows++;
+  SREG = oldSREG;
+  return ((uint64_t)overflows << 16) | count;
+}
+
+unsigned long Uptime::seconds(void)
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  unsigned long seconds = _seconds;
+  SREG = oldSREG;
+  return seconds;
+}
+
+unsigned long Uptime::minutes(void)
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  unsigned long minutes = _minutes;
+  SREG = oldSREG;
+  return minutes;
+}
+
+uint16_t Uptime::toNextSecond(void)
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  uint32_t left = UPTIME_TICKS_PER_SEC - _fraction;
+  uint16_t count = TCNT1;
+  SREG = oldSREG;
+  // second is carried by the overflow which passes it
+  uint32_t overflows = (left + TICKS_PER_OVERFLOW - 1) >> 16;
+  // 2048 ticks are about a millisecond, no division
+  return ((overflows << 16) - count) >> 11;
+}
+
+void Uptime::advance(uint16_t ms)
+{
+  uint32_t ticks = (uint32_t)ms * UPTIME_TICKS_PER_MS + _carry;
+  _carry = ticks & (TICKS_PER_OVERFLOW - 1);
+  for (uint16_t n = ticks >> 16; n > 0; n--) {
+    uint8_t oldSREG = SREG;
+    cli();
+    handleInterrupt();
+    SREG = oldSREG;
+  }
+}
+
+void Uptime::handleInterrupt(void)
+{
+  _overflows++;
+  uint32_t fraction = _fraction + TICKS_PER_OVERFLOW;
+  if (fraction >= UPTIME_TICKS_PER_SEC) {
+    fraction -= UPTIME_TICKS_PER_SEC;
+    _seconds++;
+    if (++_minuteSeconds >= 60) {
+      _minuteSeconds = 0;
+      _minutes++;
+    }
+  }
+  _fraction = fraction;
+}
+
+Uptime uptime;
+
+ISR(TIMER1_OVF_vect)
+{
+  uptime.handleInterrupt();
+}
@@ -0,0 +1,47 @@
+#ifndef Uptime_h
+#define Uptime_h
+
+#include <Arduino.h>
+#include "Elapsed.h"
+
+// Monotonic timebase on Timer1 overflow. The interrupt counts overflows
+// and carries them into whole seconds and minutes, so readers get them
+// without division. Seconds don't roll over for 136 years, unlike
+// millis()/1000 which jumps back after 49.7 days. Timer1 runs free with
+// prescaler 8 and is shared with OneWireAsync and TicklessIdle, they
+// use compare units only.
+
+// Timer1 ticks with prescaler 8
+#define UPTIME_TICKS_PER_SEC (F_CPU / 8)
+#define UPTIME_TICKS_PER_MS (UPTIME_TICKS_PER_SEC / 1000)
+
+class Uptime
+{
+  public:
+    Uptime(void);
+    // Start Timer1 if it isn't running yet and count its overflows
+    void begin(void);
+    // Timer1 ticks from start, 0.5 us at 16 MHz
+    uint64_t ticks(void);
+    // Whole seconds and minutes from start
+    unsigned long seconds(void);
+    unsigned long minutes(void);
+    // Milliseconds till seconds() changes, rounded down
+    uint16_t toNextSecond(void);
+    // Add time of power down, which stops Timer1
+    void advance(uint16_t ms);
+    // Timer1 overflow interrupt handler
+    void handleInterrupt(void);
+
+  private:
+    volatile uint32_t _overflows;
+    volatile uint32_t _fraction; // ticks of the current second
+    volatile unsigned long _seconds;
+    volatile unsigned long _minutes;
+    volatile uint8_t _minuteSeconds;
+    uint16_t _carry; // ticks of advance under overflow
+};
+
+extern Uptime uptime;
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef WATERINGCONTROL_H
+#define WATERINGCONTROL_H
+
+//#define DEBUG_WATERING
+
+// Phases of watering session
+static const uint8_t WATERING_IDLE = 0;
+static const uint8_t WATERING_PUMP = 1; // pump runs till delivery
+static const uint8_t WATERING_REST = 2; // pause between pump bursts
+static const uint8_t WATERING_DRAIN = 3; // session is done, substrate drains
+// Pump burst before the delivery latency is learned, seconds
+static const uint8_t FIRST_BURST = 25;
+// Pause limits, seconds
+static const uint8_t MIN_PAUSE = 5;
+static const uint8_t MAX_PAUSE = 60;
+
+// Closed loop watering. The pump runs in bursts until substrate reaches
+// the delivered sensor, then the session is over. Pump time from start
+// to delivery is learned as latency and limits next bursts, the time
+// the sensor stays wet after the pump stops is learned as drain time
+// and sets pauses between bursts. Learned values are rolling averages
+// of 4 sessions, kept in 1/16 sec.
+class WateringControl
+{
+public:
+  uint8_t phase;
+  uint16_t pumpSeconds; // pump run of current session
+  uint32_t totalPumpSeconds;
+
+  void start(unsigned long _now) {
+    phase = WATERING_PUMP;
+    phaseStart = sessionStart = _now;
+    pumpSeconds = 0;
+    burstSeconds = 0;
+  }
+
+  void stop() {
+    phase = WATERING_IDLE;
+  }
+
+  bool active() {
+    return phase == WATERING_PUMP || phase == WATERING_REST;
+  }
+
+  // Substrate is still wet before the first burst, session is skipped.
+  // Returns true if it is skipped.
+  bool skip(bool _delivered) {
+    if(phase != WATERING_PUMP || pumpSeconds != 0 || _delivered == false)
+      return false;
+    phase = WATERING_IDLE;
+    return true;
+  }
+
+  // Call every second, _budget is max session length in seconds.
+  // Returns true if pump has to run.
+  bool update(unsigned long _now, bool _delivered, uint16_t _budget,
+      uint8_t _minPause) {
+    switch(phase) {
+      case WATERING_PUMP:
+        if(skip(_delivered)) {
+          // substrate is still wet
+          return false;
+        }
+        if(_delivered) {
+          learn(&latency, pumpSeconds);
+          #ifdef DEBUG_WATERING
+            printf_P(PSTR("WATERING: Info: Delivered after %u sec of pump, latency %u sec.\n\r"),
+              pumpSeconds, latency >> 4);
+          #endif
+          phase = WATERING_DRAIN;
+          phaseStart = _now;
+          return false;
+        }
+        if(_now - sessionStart >= _budget) {
+          // substrate doesn't come, stop by time
+          #ifdef DEBUG_WATERING
+            printf_P(PSTR("WATERING: Warning: No delivery in %u sec.\n\r"),
+              pumpSeconds);
+          #endif
+          phase = WATERING_IDLE;
+          return false;
+        }
+        if(burstSeconds >= burstLimit()) {
+          phase = WATERING_REST;
+          phaseStart = _now;
+          return false;
+        }
+        burstSeconds++;
+        pumpSeconds++;
+        totalPumpSeconds++;
+        return true;
+
+      case WATERING_REST:
+        if(_now - phaseStart >= max(pause(), _minPause)) {
+          phase = WATERING_PUMP;
+          burstSeconds = 0;
+        }
+        return false;
+
+      case WATERING_DRAIN:
+        // wait for the sensor to dry
+        if(_delivered == false || _now - phaseStart >= 255) {
+          learn(&drain, _now - phaseStart);
+          phase = WATERING_IDLE;
+        }
+        return false;
+    }
+    return false;
+  }
+
+  // Learned latency from pump start to delivery, seconds
+  uint8_t deliveryLatency() {
+    return latency >> 4;
+  }
+
+private:
+  unsigned long sessionStart, phaseStart;
+  uint16_t latency, drain; // 1/16 sec
+  uint8_t burstSeconds;
+
+  // A quarter longer than learned latency, so one burst usually
+  // reaches the sensor
+  uint8_t burstLimit() {
+    if(latency == 0)
+      return FIRST_BURST;
+    uint16_t limit = (latency >> 4) + (latency >> 6) + 1;
+    return min(limit, 255);
+  }
+
+  // Pause is half of drain time, substrate soaks meanwhile
+  uint8_t pause() {
+    uint16_t value = drain >> 5;
+    return constrain(value, MIN_PAUSE, MAX_PAUSE);
+  }
+
+  static void learn(uint16_t* _average, uint16_t _seconds) {
+    uint16_t sample = min(_seconds, 4095) << 4;
+    *_average = *_average == 0 ? sample :
+      *_average - (*_average >> 2) + (sample >> 2);
+  }
+};
+
+#endif // __WATERINGCONTROL_H__
@@ -0,0 +1,53 @@
+#ifndef ZONE_H
+#define ZONE_H
+
+#include "WateringControl.h"
+
+// Count of grow zones, every zone has own schedule, pumps, lamp and
+// substrate sensors
+#ifndef ZONES
+#define ZONES 1
+#endif
+
+static const uint8_t RELAY_NONE = 0xFF;
+// Seconds between pump starts, they don't start at once
+static const uint8_t PUMP_STAGGER = 3;
+
+// Schedule of zone, it is stored in settings
+struct ZoneConfig {
+  uint8_t wateringDuration, wateringSunnyPeriod, wateringPeriod;
+  uint8_t mistingDuration, mistingSunnyPeriod, mistingPeriod;
+};
+
+// Relay bank outputs of zone in order of misting pump, watering pump
+// and lamp, RELAY_NONE if zone doesn't have it
+struct ZoneRelays {
+  uint8_t relays[3];
+};
+
+// Runtime state of zone
+struct ZoneState {
+  unsigned long lastMisting, lastWatering; // seconds
+  WateringControl watering;
+  uint8_t startMisting; // seconds left
+  uint8_t substrateTemp;
+};
+
+// Shared power of pumps, grants one pump start per PUMP_STAGGER
+class PumpArbiter
+{
+public:
+  bool grant(unsigned long _now) {
+    if(started && _now - lastStart < PUMP_STAGGER)
+      return false;
+    started = true;
+    lastStart = _now;
+    return true;
+  }
+
+private:
+  bool started;
+  unsigned long lastStart;
+};
+
+#endif // __ZONE_H__
@@ -2,6 +2,7 @@
 #define BEEP_H
 
 #include "pitches.h"
+#include "Elapsed.h"
 
 static const uint8_t ONE_BEEP = 1;
 static const uint8_t TWO_BEEP = 2;
@@ -24,6 +25,13 @@ public:
     beepCount = _beepCount;
   }
 
+  // Milliseconds till update() has to play the next note
+  uint16_t nextUpdate() {
+    if( beepCount == 0 )
+      return 0xFFFF;
+    return remaining(millis(), time, notePause);
+  }
+
   void update() {
     // fast exit
     if( beepCount == 0 )
@@ -37,7 +45,7 @@ public:
       return;
     }
     // pause between notes
-    if( millis() - time < notePause )
+    if( elapsed(millis(), time, notePause) == false )
       return;
     // play current note
     noTone(pin);
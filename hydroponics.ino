@@ -7,7 +7,15 @@
 #include "DHT.h"
 #include "DS18B20.h"
 #include "BH1750.h"
+#include "AdcSampler.h"
+#include "HistoryLog.h"
+#include "RelayBank.h"
 #include "LowPower.h"
+#include "TicklessIdle.h"
+#include "Uptime.h"
+#include "Rules.h"
+#include "Controller.h"
+#include "Thermal.h"
 //#define MESH
 #ifdef MESH
   #include "nRF24L01.h"
@@ -38,6 +46,8 @@ LcdPanel panel;
   const int NUM_INTERFACES = 1;
   // Declare radio
   RF24 radio(CE_PIN, CS_PIN);
+  // Radio IRQ isn't wired, it is polled, ms
+  static const uint8_t RADIO_POLL = 10;
 #endif
 
 // Declare DHT sensor
@@ -45,9 +55,7 @@ LcdPanel panel;
 
 // Declare variables
 unsigned long timerSec, timer100sec, timerMin; 
-unsigned long lastMisting, lastWatering, startWatering;
-uint16_t sunrise;
-uint8_t startMisting;
+uint8_t historyDay;
 bool substTankFull;
 
 // Define pins
@@ -57,22 +65,119 @@ static const uint8_t SUBSTRATE_FULLPIN = A0;
 static const uint8_t SUBSTRATE_DELIVEREDPIN = A1;
 static const uint8_t WATER_LEVELPIN = A6;
 static const uint8_t SUBSTRATE_LEVELPIN = A7;
-static const uint8_t PUMP_WATERINGPIN = 4;
-static const uint8_t PUMP_MISTINGPIN = 5;
-static const uint8_t LAMPPIN = 7;
-// Define relay states
-static const uint8_t RELAY_ON = 0;
-static const uint8_t RELAY_OFF = 1;
+// Relays in order of state keys from PUMP_MISTING, pumps can't run
+// more than PUMPS_LIMIT at the same time
+static const uint8_t PUMPS = 1;
+static const uint8_t PUMPS_LIMIT = 2;
+static const RelayConfig relayTable[] PROGMEM = {
+  {_SFR_MEM_ADDR(PORTD), PD5, PUMPS, true}, // misting pump, pin 5
+  {_SFR_MEM_ADDR(PORTD), PD4, PUMPS, true}, // watering pump, pin 4
+  {_SFR_MEM_ADDR(PORTD), PD7, 0, true} // lamp, pin 7
+};
+RelayBank relayBank(relayTable, sizeof(relayTable)/sizeof(RelayConfig));
+// Relay bank outputs of zones: misting pump, watering pump, lamp. Add a
+// row per zone together with its relays in relayTable and ZONES, zones
+// without a row have no relays.
+static const ZoneRelays zoneRelays[] PROGMEM = {
+  {{0, 1, 2}}
+};
 
-// DS18B20 sensors address
-const byte ds18b20Address[2][8] PROGMEM = {
-     0x28, 0x28, 0x88, 0xD6, 0x05, 0x00, 0x00, 0xC1,
-     0x28, 0xFF, 0xA8, 0x0C, 0x11, 0x14, 0x00, 0x61
+// Hardware of controller
+class ArduinoHal
+{
+public:
+  unsigned long seconds() {
+    return uptime.seconds();
+  }
+  uint8_t hour() {
+    return clock.hour();
+  }
+  uint8_t minute() {
+    return clock.minute();
+  }
+  bool relay(uint8_t _output, bool _on) {
+    return relayBank.set(_output, _on);
+  }
+  uint8_t zoneRelay(uint8_t _zone, uint8_t _relay) {
+    if(_zone >= sizeof(zoneRelays)/sizeof(ZoneRelays))
+      return RELAY_NONE;
+    return pgm_read_byte(&zoneRelays[_zone].relays[_relay-PUMP_MISTING]);
+  }
+  void beep(uint8_t _count) {
+    ::beep.play(_count);
+  }
+  void settingsChanged() {
+    storage.changed = true;
+  }
+} hal;
+// Control policy, first matching rule of target wins. Overlay in
+// EEPROM goes before it.
+const Rule ruleTable[] PROGMEM = {
+  // target, value, when, unless, hours, lux, air temp, alarm
+  // sunny, clock is lost
+  { RULE_MODE, MODE_SUNNY, 0, 0, 0, 0, 2500, LUX_ANY,
+    TEMP_ANY_MIN, TEMP_ANY_MAX, ERROR_CLOCK },
+  // sunny day
+  { RULE_MODE, MODE_SUNNY, IN_SILENT_DAY, 0, 0, 0, 2500, LUX_ANY,
+    TEMP_ANY_MIN, TEMP_ANY_MAX, RULE_ANY },
+  // dark, clock is lost
+  { RULE_MODE, MODE_NIGHT, 0, 0, 0, 0, 0, 200,
+    TEMP_ANY_MIN, TEMP_ANY_MAX, ERROR_CLOCK },
+  // silent night
+  { RULE_MODE, MODE_NIGHT, 0, IN_SILENT_DAY, 0, 0, 0, LUX_ANY,
+    TEMP_ANY_MIN, TEMP_ANY_MAX, RULE_ANY },
+  // turn off lamp on errors
+  { RULE_LAMP, 0, 0, 0, 0, 0, 0, LUX_ANY,
+    TEMP_ANY_MIN, TEMP_ANY_MAX, RULE_ERRORS },
+  // try to up temperature
+  { RULE_LAMP, 1, IN_AIR_COLD, 0, 0, 0, 101, LUX_ANY,
+    TEMP_ANY_MIN, TEMP_ANY_MAX, RULE_ANY },
+  // light enough
+  { RULE_LAMP, 0, IN_BRIGHT, 0, 0, 0, 0, LUX_ANY,
+    TEMP_ANY_MIN, TEMP_ANY_MAX, RULE_ANY },
+  // keep light day
+  { RULE_LAMP, 1, IN_LIGHT_DAY, 0, 0, 0, 0, LUX_ANY,
+    TEMP_ANY_MIN, TEMP_ANY_MAX, RULE_ANY },
+  // watch sunrise in the morning
+  { RULE_DAWN, 1, 0, IN_BRIGHT|IN_AIR_COLD, 5, 9, 301, LUX_ANY,
+    TEMP_ANY_MIN, TEMP_ANY_MAX, RULE_ERRORS|RULE_NOT },
 };
+RuleTable rules(ruleTable, sizeof(ruleTable)/sizeof(Rule));
+Controller<ArduinoHal> controller(hal, settings, profiles, states, alarms,
+  rules);
+// Throttling of hot computer
+ThermalGuard thermal;
+// Hours before empty tank to ask for refill
+static const uint8_t REFILL_AHEAD = 24;
+
+// Hourly records in spare EEPROM
+EepromLogStorage logStorage(LOG_EEPROM_ADDRESS, LOG_EEPROM_SIZE);
+// Series of the log are air, humidity, substrate, light and relays of
+// zones: watering 1, misting 2, lamp 4, next zones follow by 3 bits,
+// 5 zones in every value
+#define LOG_RELAY_VALUES ((ZONES + 4) / 5)
+#if 4 + LOG_RELAY_VALUES > LOG_SERIES
+#error "Relays of all zones don't fit into LOG_SERIES of the log"
+#endif
+HistoryLog historyLog(&logStorage, 64, 3600, 4 + LOG_RELAY_VALUES);
+uint8_t logMinutes;
+
+// Level sensors sampler
+AdcSampler levels;
+uint8_t substrateLevel, waterLevel;
+
+// DS18B20 sensors roles
+static const uint8_t COMPUTER_SENSOR = 1;
+static const uint8_t SUBSTRATE_SENSOR = 2;
 // 1-Wire object
 OneWire onewire(ONE_WIRE_BUS);
+// 1-Wire background transactions
+OneWireAsync onewireAsync(ONE_WIRE_BUS);
 // DS18B20 sensors object
-DS18B20 ds18b20(&onewire);
+DS18B20 ds18b20(&onewire, &onewireAsync);
+
+// Sleep between tasks
+TicklessIdle idle;
 
 /****************************************************************************/
 
@@ -87,20 +192,51 @@ void setup()
   stdout = stderr = &serial_out;
   // prevent continiously restart
   delay(500); // millis
+  // seconds and minutes of uptime
+  uptime.begin();
   // restart if low memory
   softResetMem(512); // bytes
   // restart after freezing for 8 sec
   softResetTimeout();
+  // switch off relays
+  relayBank.limit(PUMPS, PUMPS_LIMIT);
+  relayBank.begin();
   #ifdef MESH
     // initialize network
     rf24init();
   #endif
-  // initialize DS18B20 with 9 bits resolution
-  ds18b20.begin(9);
+  // sample level sensors in the background, low level is above 700
+  substrateLevel = levels.attach(SUBSTRATE_LEVELPIN, 680, 720);
+  waterLevel = levels.attach(WATER_LEVELPIN, 680, 720);
+  levels.begin();
+  // continue long-term log after the newest block
+  historyLog.begin();
+  // rules of EEPROM overlay take priority
+  rules.load(RULES_EEPROM_ADDRESS, RULES_EEPROM_SIZE);
+  // initialize DS18B20 with 9 bits resolution, new sensors are in substrate
+  ds18b20.begin(9, DS18B20_EEPROM_ADDRESS, SUBSTRATE_SENSOR);
+  // first sensor is inside of computer if nobody is assigned
+  if(ds18b20.roleCount(COMPUTER_SENSOR) == 0 && ds18b20.count() > 1) {
+    ds18b20.setRole(0, COMPUTER_SENSOR);
+  }
+  // measure in the background
+  onewireAsync.begin();
   // request all sensors for measurement
   ds18b20.request();
   // initialize lcd panel
   panel.begin();
+  // grow plan of loaded settings
+  profiles.begin();
+  // buttons wake up from sleep
+  idle.attach(A2);
+  idle.attach(A3);
+  idle.begin();
+  #ifdef DEBUG_HISTORY
+    printf_P(PSTR("HISTORY: Info: Series %u bytes, free %d bytes.\n\r"),
+      (unsigned int)(sizeof(airTempHistory) + sizeof(humidityHistory) + 
+      sizeof(substrateTempHistory) + sizeof(computerTempHistory) + 
+      sizeof(lightHistory)), freeMemory());
+  #endif
 }
 
 //
@@ -111,21 +247,27 @@ void loop()
   // watchdog
   heartbeat();
   // timer fo 1 sec
-  if(millis()/ONE_SEC - timerSec >= 1) {
-    timerSec = millis()/ONE_SEC;
+  if(uptime.seconds() != timerSec) {
+    timerSec = uptime.seconds();
     // check level sensors
     check_levels();
-    // update watering
-    watering();
-    // update misting
-    misting();
+    // update watering and misting
+    controller.update();
+    // cool down between seconds
+    if(thermal.level >= THERMAL_CRITICAL) {
+      nap();
+    }
     // timer for 1 min
-    if(timerSec - timerMin >= 60) {
+    if(elapsed(timerSec, timerMin, 60)) {
       timerMin = timerSec;
+      // update sensors history
+      update_history();
+      // estimate tanks consumption
+      check_tanks();
       // manage light
-      doLight();
+      controller.doLight();
       // manage misting and watering
-      doWork();
+      controller.doWork();
       // save settings
       #ifdef DEBUG_EEPROM
         printf_P(PSTR("EEPROM: Info: storage changed->%d, ok->%d.\n\r"), 
@@ -135,11 +277,15 @@ void loop()
         // WARNING: EEPROM can burn!
         storage.save();
         storage.changed = false;
+        // values of calendar follow settings
+        calendar.refresh();
       }
       #ifdef MESH
         //meshTest();
         // send data to base
         sendCommand( 1, (void*) &states, sizeof(states) );
+        sendCommand( ALARMS, (void*) &alarms.pending, 
+          sizeof(alarms.pending) );
         /*sendCommand( 1, (void*) &"Hydroponics", sizeof("Hydroponics") );
         sendCommand( HUMIDITY, (void*) states[HUMIDITY], 
           sizeof(states[HUMIDITY]) );
@@ -157,29 +303,40 @@ void loop()
           sizeof(states[PUMP_WATERING]) );
         sendCommand( LAMP, (void*) states[LAMP], 
           sizeof(states[LAMP]) );
-        sendCommand( WARNING, (void*) states[WARNING], 
-          sizeof(states[WARNING]) );
-        sendCommand( ERROR, (void*) states[ERROR], 
-          sizeof(states[ERROR]) );*/
+*/
       #endif
     }
     // timer for 100 sec
-    if(timerSec - timer100sec >= 100) {
-      timer100sec = millis()/ONE_SEC;
+    if(elapsed(timerSec, timer100sec, 100)) {
+      timer100sec = timerSec;
+      #ifdef DEBUG
+        unsigned long start = millis();
+      #endif
       // system check
       checkSystem();
       #ifdef DEBUG
         printf_P(PSTR("Loop: Info: System check takes: %u ms\n\r"),
-          millis()-timer100sec*ONE_SEC);
+          (unsigned int)(millis()-start));
       #endif
     }
   }
+  // read DS18B20 sensors in the background
+  ds18b20.update();
+  // next sampling window of level sensors
+  levels.update();
   // update LCD 
   panel.update();
   #ifdef MESH
     // update network
     rf24receive();
+    idle.wakeIn(RADIO_POLL);
   #endif
+  // sleep till the next task
+  idle.wakeIn(uptime.toNextSecond());
+  idle.wakeIn(panel.nextUpdate());
+  idle.wakeIn(ds18b20.nextUpdate());
+  idle.wakeIn(levels.nextUpdate());
+  idle.sleep();
 }
 
 /****************************************************************************/
@@ -206,6 +363,27 @@ void loop()
 #endif
 /****************************************************************************/
 
+// Graded throttling of loads and LCD by thermal level
+void throttle() {
+  menu.dimmed = thermal.level >= THERMAL_WARM;
+  menu.slowdown = thermal.level;
+  controller.throttle(thermal.level);
+}
+
+// Short power down, relays keep their state. Skipped while pumps run
+// and during 1-Wire transactions which need exact timing.
+void nap() {
+  if(relayBank.state() != 0 || onewireAsync.busy()) {
+    return;
+  }
+  LowPower.powerDown(SLEEP_250MS, 1, ADC_ON, BOD_OFF);
+  // timers were stopped
+  idle.compensate(250);
+  uptime.advance(250);
+  // sleep took watchdog, arm it again
+  softResetTimeout();
+}
+
 bool read_DHT() {
   DHT dht(DHTPIN, DHTTYPE);
   dht.begin();
@@ -218,7 +396,7 @@ bool read_DHT() {
     #endif
     return false;
   }
-  if(DHTTYPE == "DHT11" && 
+  if(DHTTYPE == DHT11 && 
       (states[HUMIDITY] >= 95 || states[AIR_TEMP] >= 50)) {
     #ifdef DEBUG_DHT
       printf_P(PSTR("DHT Sensor: Error: sensor broken!\n\r"));
@@ -237,8 +415,17 @@ bool read_DS18B20() {
     // Leave if the sesors measurement isn't ready
     return true;
   }
+  // read all sensors at once, roles keep working without failed ones
+  if(ds18b20.readAll() == false) {
+    #ifdef DEBUG_DS18B20
+      printf_P(PSTR("DS18B20: Warning: Some of %d sensors failed!\n\r"), 
+        ds18b20.count());
+    #endif
+  }
+  // request all sensors for next measurement
+  ds18b20.request();
   // read computer sensor
-  float value = ds18b20.readTemperature(FA(ds18b20Address[0]));
+  float value = ds18b20.roleTemperature(COMPUTER_SENSOR);
   if(value == TEMP_ERROR) {
     #ifdef DEBUG_DS18B20
       printf_P(PSTR("DS18B20: Error: Computer sensor failed!\n\r"));
@@ -250,8 +437,8 @@ bool read_DS18B20() {
     printf_P(PSTR("DS18B20: Info: Computer temperature: %dC.\n\r"), 
       states[COMPUTER_TEMP]);
   #endif
-  // read substrate sensor
-  value = ds18b20.readTemperature(FA(ds18b20Address[1]));
+  // average of substrate sensors
+  value = ds18b20.roleTemperature(SUBSTRATE_SENSOR);
   if(value == TEMP_ERROR) {
     #ifdef DEBUG_DS18B20
       printf_P(PSTR("DS18B20: Error: Substrate sensor failed!\n\r"));
@@ -263,8 +450,14 @@ bool read_DS18B20() {
     printf_P(PSTR("DS18B20: Info: Substrate temperature: %dC.\n\r"), 
       states[SUBSTRATE_TEMP]);
   #endif
-  // request all sensors for measurement
-  return ds18b20.request();
+  // zones without own sensors share the first one
+  for(uint8_t z=0; z<ZONES; z++) {
+    value = ds18b20.roleTemperature(SUBSTRATE_SENSOR+z);
+    if(value == TEMP_ERROR)
+      value = states[SUBSTRATE_TEMP];
+    controller.zones[z].substrateTemp = value;
+  }
+  return true;
 }
 
 bool read_BH1750() {
@@ -291,24 +484,18 @@ void check_levels() {
     printf_P(PSTR("LEVELS: Info: Substrate delivered: %d.\n\r"), 
       digitalRead(SUBSTRATE_DELIVEREDPIN));
   #endif
-  if(digitalRead(SUBSTRATE_DELIVEREDPIN) == 1) {
-    states[WARNING] = INFO_SUBSTRATE_DELIVERED;
-    return;
-  }
-  // no pull-up for A6 and A7
-  pinMode(SUBSTRATE_LEVELPIN, INPUT);
+  alarms.set(INFO_SUBSTRATE_DELIVERED, 
+    digitalRead(SUBSTRATE_DELIVEREDPIN) == 1);
   #ifdef DEBUG_LEVELS
     printf_P(PSTR("LEVELS: Info: Substrate level: %d.\n\r"), 
-      analogRead(SUBSTRATE_LEVELPIN));
+      levels.value(substrateLevel));
   #endif
-  if(analogRead(SUBSTRATE_LEVELPIN) > 700) {
-    // prevent fail alert
-    if(millis()/ONE_SEC > lastWatering + 140)
-      states[ERROR] = ERROR_NO_SUBSTRATE;
-    else
-      states[WARNING] = WARNING_SUBSTRATE_LOW;
-    return; 
-  }
+  bool substrateLow = levels.isHigh(substrateLevel);
+  // prevent fail alert
+  bool afterWatering = 
+    elapsed(uptime.seconds(), controller.lastWatering, 140) == false;
+  alarms.set(ERROR_NO_SUBSTRATE, substrateLow && !afterWatering);
+  alarms.set(WARNING_SUBSTRATE_LOW, substrateLow && afterWatering);
   pinMode(SUBSTRATE_FULLPIN, INPUT_PULLUP);
   #ifdef DEBUG_LEVELS
     printf_P(PSTR("LEVELS: Info: Substrate full: %d.\n\r"), 
@@ -317,365 +504,135 @@ void check_levels() {
   if(digitalRead(SUBSTRATE_FULLPIN) == 1) { 	  
   	if(substTankFull == false) {
       substTankFull = true;
-      states[WARNING] = INFO_SUBSTRATE_FULL;
-      return;
+      alarms.raise(INFO_SUBSTRATE_FULL);
     }
   } else {
   	substTankFull = false;
   }
-  // no pull-up for A6 and A7
-  pinMode(WATER_LEVELPIN, INPUT);
   #ifdef DEBUG_LEVELS
     printf_P(PSTR("LEVELS: Info: Water level: %d.\n\r"), 
-      analogRead(WATER_LEVELPIN));
+      levels.value(waterLevel));
   #endif
-  if(analogRead(WATER_LEVELPIN) > 700) {
-    states[WARNING] = WARNING_NO_WATER;
-    return;
-  }
+  alarms.set(WARNING_NO_WATER, levels.isHigh(waterLevel));
 }
 
-void relayOn(uint8_t relay) {
-  if(states[relay]) {
-    // relay is already on
-    return;
-  }
-  bool status = relays(relay, RELAY_ON);
-  if(status) {
-    #ifdef DEBUG_RELAY
-      printf_P(PSTR("RELAY: Info: '%s' is enabled.\n\r"), relay);
-    #endif
-    states[relay] = true;
-  }
+// Relay is in the bits of relays, zones without it have RELAY_NONE
+bool relayOn(uint32_t _relays, uint8_t _relay) {
+  return _relay < RELAY_MAX && (_relays >> _relay) & 1;
 }
 
-void relayOff(uint8_t relay) {
-  if(states[relay] == false) {
-    // relay is already off
-    return;
-  }
-  bool status = relays(relay, RELAY_OFF);
-  if(status) {
-    #ifdef DEBUG_RELAY
-      printf_P(PSTR("RELAY: Info: '%s' is disabled.\n\r"), relay);
-    #endif
-    states[relay] = false;
+void update_history() {
+  #ifdef DEBUG_HISTORY
+    unsigned long start = micros();
+  #endif
+  // new day at midnight
+  if(clock.day() != historyDay) {
+    historyDay = clock.day();
+    airTempHistory.startDay();
+    humidityHistory.startDay();
+    substrateTempHistory.startDay();
+    computerTempHistory.startDay();
+    lightHistory.startDay();
+    // grow calendar by days from 2000
+    if(alarms.isActive(ERROR_CLOCK) == false &&
+        calendar.update(clock.secondstime()/86400L)) {
+      storage.changed = true;
+    }
   }
+  airTempHistory.update(states[AIR_TEMP]);
+  humidityHistory.update(states[HUMIDITY]);
+  substrateTempHistory.update(states[SUBSTRATE_TEMP]);
+  computerTempHistory.update(states[COMPUTER_TEMP]);
+  lightHistory.update(states[LIGHT]);
+  if(++logMinutes >= 60) {
+    // relays which were on during the hour, short runs too
+    uint32_t relays = relayBank.wasOn();
+    uint16_t values[LOG_SERIES] = {
+      airTempHistory.hour().avg, humidityHistory.hour().avg,
+      substrateTempHistory.hour().avg, lightHistory.hour().avg
+    };
+    for(uint8_t z=0; z<ZONES; z++) {
+      uint16_t bits = 
+        (relayOn(relays, hal.zoneRelay(z, PUMP_WATERING)) ? 1 : 0) | 
+        (relayOn(relays, hal.zoneRelay(z, PUMP_MISTING)) ? 2 : 0) | 
+        (relayOn(relays, hal.zoneRelay(z, LAMP)) ? 4 : 0);
+      values[4 + z/5] |= bits << 3*(z%5);
+    }
+    // align to the hour, so next records follow by interval
+    uint32_t time = clock.unixtime();
+    historyLog.append(time - time % 3600, values);
+    logMinutes = 0;
+  }
+  #ifdef DEBUG_HISTORY
+    printf_P(PSTR("HISTORY: Info: Update takes: %u us, air %d-%dC, %d%%/h.\n\r"),
+      (unsigned int)(micros()-start), airTempHistory.todayMin(), 
+      airTempHistory.todayMax(), humidityHistory.rate());
+  #endif
 }
 
-bool relays(uint8_t relay, uint8_t state) {
-  if(relay == PUMP_MISTING) {
-    pinMode(PUMP_MISTINGPIN, OUTPUT);
-    digitalWrite(PUMP_MISTINGPIN, state);
-    return true;
-  } 
-  if(relay == PUMP_WATERING) {
-    pinMode(PUMP_WATERINGPIN, OUTPUT);    
-    digitalWrite(PUMP_WATERINGPIN, state);
-    return true;
-  } 
-  if(relay == LAMP) {
-    pinMode(LAMPPIN, OUTPUT);
-    digitalWrite(LAMPPIN, state);
-    return true;
-  }
-  #ifdef DEBUG_RELAY
-    printf_P(PSTR("RELAY: Error: '%s' is unknown!\n\r"), relay);
+void check_tanks() {
+  states[SUBSTRATE_LEVEL] = substrateTank.update(
+    levels.value(substrateLevel), settings.substrateLevels);
+  states[WATER_LEVEL] = waterTank.update(
+    levels.value(waterLevel), settings.waterLevels);
+  #ifdef DEBUG_LEVELS
+    printf_P(PSTR("LEVELS: Info: Substrate %d%% for %u h, water %d%% for %u h.\n\r"), 
+      states[SUBSTRATE_LEVEL], substrateTank.hoursLeft(),
+      states[WATER_LEVEL], waterTank.hoursLeft());
   #endif
-  return false;
+  // ask for refill ahead of time
+  alarms.set(WARNING_REFILL_SUBSTRATE, 
+    substrateTank.hoursLeft() < REFILL_AHEAD);
+  alarms.set(WARNING_REFILL_WATER, 
+    waterTank.hoursLeft() < REFILL_AHEAD);
 }
 
 void checkSystem() {
   #ifdef DEBUG
     printf_P(PSTR("Free memory: %d bytes.\n\r"), freeMemory());
+    uint8_t sleepPercent;
+    uint16_t sleeps;
+    idle.stats(&sleepPercent, &sleeps);
+    printf_P(PSTR("IDLE: Info: Sleep %d%% of time in %u sleeps.\n\r"),
+      sleepPercent, sleeps);
   #endif
   // check if memory less than 600 bytes
-  if(freeMemory() < 600) {
-    states[ERROR] = ERROR_LOW_MEMORY;
-    return;
-  }
-  // prevent burn system
-  if(states[COMPUTER_TEMP] >= 45) {
-    #ifdef DEBUG
-      printf_P(PSTR("SLEEP: Info: Go to long sleep.\n\r"));
-    #endif
-    // turn off relays
-    relayOff(LAMP);
-    relayOff(PUMP_WATERING);
-    relayOff(PUMP_MISTING);
-    // tunr off lcd
-    lcd.setBacklight(false);
-    // power down computer for 64 sec
-    LowPower.powerDown(SLEEP_8S, 8, ADC_OFF, BOD_OFF); 
+  alarms.set(ERROR_LOW_MEMORY, freeMemory() < 600);
+  if(alarms.isActive(ERROR_LOW_MEMORY)) {
     return;
   }
   // check EEPROM
-  if(storage.ok == false) {
-    states[ERROR] = ERROR_EEPROM;
-    return;
-  }
+  alarms.set(ERROR_EEPROM, storage.ok == false);
   // check clock
-  if(clock.year() < 2014 || clock.year() > 2024) {
-    states[ERROR] = ERROR_CLOCK;
-    return;  
-  }
-  // read DHT sensor
-  if(read_DHT() == false) {
-    states[ERROR] = ERROR_DHT;
-    return;
-  }
-  // read BH1750 sensor
-  if(read_BH1750() == false) {
-    states[ERROR] = ERROR_BH1750;
-    return;
-  }
-  // read DS18B20 sensors
-  if(read_DS18B20() == false) {
-    states[ERROR] = ERROR_DS18B20;
-    return;
+  alarms.set(ERROR_CLOCK, clock.year() < CLOCK_YEAR_MINIMUM || 
+    clock.year() > CLOCK_YEAR_MAXIMUM);
+  // read sensors
+  alarms.set(ERROR_DHT, read_DHT() == false);
+  // light sensor waits while computer is hot, lamp is off anyway
+  if(thermal.level < THERMAL_HOT) {
+    alarms.set(ERROR_BH1750, read_BH1750() == false);
+  }
+  alarms.set(ERROR_DS18B20, read_DS18B20() == false);
+  // prevent burn system
+  if(alarms.isActive(ERROR_DS18B20) == false &&
+      thermal.update(states[COMPUTER_TEMP])) {
+    throttle();
   }
-  // reset error
-  states[ERROR] = NO_ERROR;
-  
   // check substrate temperature
-  if(states[SUBSTRATE_TEMP] <= settings.subsTempMinimum) {
-    states[WARNING] = WARNING_SUBSTRATE_COLD;
-    return;
+  if(alarms.isActive(ERROR_DS18B20) == false) {
+    bool cold = false;
+    for(uint8_t z=0; z<ZONES; z++)
+      cold |= controller.zones[z].substrateTemp <= settings.subsTempMinimum;
+    alarms.set(WARNING_SUBSTRATE_COLD, cold);
   }
   // check air temperature
-  if(states[AIR_TEMP] <= settings.airTempMinimum) {
-    states[WARNING] = WARNING_AIR_COLD;
-    return;
-  } else if(states[AIR_TEMP] >= settings.airTempMaximum) {
-    states[WARNING] = WARNING_AIR_HOT;
-  }
-  // reset warning
-  states[WARNING] = NO_WARNING;
+  if(alarms.isActive(ERROR_DHT) == false) {
+    alarms.set(WARNING_AIR_COLD, 
+      states[AIR_TEMP] <= settings.airTempMinimum);
+    alarms.set(WARNING_AIR_HOT, 
+      states[AIR_TEMP] >= settings.airTempMaximum);
+  }
+  // show substrate tank info till next check
+  alarms.clear(INFO_SUBSTRATE_FULL);
 }
 
-void doWork() {
-  // don't use cold water
-  if(states[WARNING] == WARNING_SUBSTRATE_COLD) {
-    return;
-  }
-  // sunny time
-  if( isSunny() ) {
-    #ifdef DEBUG
-      printf_P(PSTR("Work: Info: Sunny time.\n\r"));
-    #endif
-    checkTimer(settings.wateringSunnyPeriod, settings.mistingSunnyPeriod);
-    return;
-  }
-  // night time
-  if( isNight() ) {
-    #ifdef DEBUG
-      printf_P(PSTR("Work: Info: Night time.\n\r"));
-    #endif
-    states[WATERING] = 0;
-    states[MISTING] = 0;
-    // nothing, silent night
-    return;
-  }
-  // other time period
-  checkTimer(settings.wateringPeriod, settings.mistingPeriod);
-}
-
-bool isSunny() {
-  if(states[LIGHT] < 2500) {
-    return false;
-  }
-  if(states[ERROR] == ERROR_CLOCK) {
-    return true;
-  }
-  return settings.silentMorning <= clock.hour() &&
-    clock.hour() < settings.silentEvening;
-}
-
-bool isNight() {
-  if(states[ERROR] == ERROR_CLOCK && states[LIGHT] < 200) {
-    return true;
-  }
-  return settings.silentEvening <= clock.hour() || 
-    clock.hour() < settings.silentMorning;
-}
-
-void checkTimer(uint8_t _wateringMinute, uint8_t _mistingMinute) {
-  // watering
-  unsigned long diff = (millis()/ONE_SEC-lastWatering)/60;
-  if(_wateringMinute > diff)
-    diff = _wateringMinute-diff;
-  else
-    diff = 0;
-  states[WATERING] = diff;
-  #ifdef DEBUG
-    printf_P(PSTR("Work: Info: Watering after: %u min.\n\r"), diff);
-  #endif
-  if(_wateringMinute != 0 && diff == 0) {
-    startWatering = millis()/ONE_SEC;
-    // update sensors history
-    states[PREV_AIR_TEMP] = states[AIR_TEMP];
-    states[PREV_HUMIDITY] = states[HUMIDITY];
-    states[PREV_SUBSTRATE_TEMP] = states[SUBSTRATE_TEMP];
-    states[PREV_LIGHT] = states[LIGHT];
-    states[PREV_COMPUTER_TEMP] = states[COMPUTER_TEMP];
-  }
-
-  // check humidity
-  if(states[HUMIDITY] <= settings.humidMinimum)
-    _mistingMinute /= 2; // twice often
-  else if(states[HUMIDITY] >= settings.humidMaximum)
-    _mistingMinute *= 2; // twice rarely
-
-  // misting
-  diff = (millis()/ONE_SEC-lastMisting)/60;
-  if(_mistingMinute > diff)
-    diff = _mistingMinute-diff;
-  else
-    diff = 0;
-  states[MISTING] = diff;
-  #ifdef DEBUG
-    printf_P(PSTR("Work: Info: Misting after: %u min.\n\r"), diff);
-  #endif
-  if(_mistingMinute != 0 && diff == 0) {
-    startMisting = settings.mistingDuration;
-  }
-}
-
-void doLight() { 
-  if(states[ERROR] != NO_ERROR) {
-    // turn off lamp
-    relayOff(LAMP);
-    return;
-  }
-  // try to up temperature
-  if(states[AIR_TEMP] <= settings.airTempMinimum &&
-      states[LIGHT] > 100) {
-    // turn on lamp
-    relayOn(LAMP);
-    return;
-  }
-  // light enough
-  if(states[LIGHT] > settings.lightMinimum) {
-    // turn off lamp
-    relayOff(LAMP);
-    return;
-  }
-  uint16_t dtime = clock.hour()*60+clock.minute();
-  // set sunrise
-  if(states[LIGHT] > 300 && states[LIGHT] <= settings.lightMinimum) {
-    bool morning = 4 < clock.hour() && clock.hour() <= 8;
-    // save sunrise time
-    if(morning && sunrise == 0) {
-      sunrise = dtime;
-    } else
-    // watch for 30 min to check
-    if(morning && sunrise+30 <= dtime) {
-      #ifdef DEBUG
-        printf_P(PSTR("Light: Info: Set new Day Start time: %02d:%02d.\n\r"), 
-        sunrise/60, sunrise%60);
-      #endif
-      // save to EEPROM if big difference (more than 30 min)
-      if(sunrise-90 > settings.lightDayStart || 
-          sunrise-30 < settings.lightDayStart) {
-        storage.changed = true;
-      }
-      // setup 1 hour earlier
-      settings.lightDayStart = sunrise-60;
-      // prevent rewrite, move to out of morning
-      sunrise += 300;
-    }
-  }
-  // reset sunrise time
-  sunrise = 0;
-  // keep light day
-  uint16_t lightDayEnd = settings.lightDayStart+(settings.lightDayDuration*60);
-  if(settings.lightDayStart <= dtime && dtime <= lightDayEnd) {
-    #ifdef DEBUG
-      printf_P(PSTR("Light: Info: Lamp On till: %02d:%02d.\n\r"), 
-        lightDayEnd/60, lightDayEnd%60);
-    #endif
-    // turn on lamp
-    relayOn(LAMP);
-    return;
-  }
-  // turn off lamp
-  relayOff(LAMP);
-}
-
-void misting() {
-  // quick check
-  if(startMisting == 0 || states[WARNING] == WARNING_NO_WATER) {
-    // stop misting
-    if(states[PUMP_MISTING]) {
-      #ifdef DEBUG
-        printf_P(PSTR("Misting: Info: Stop misting.\n\r"));
-      #endif
-      relayOff(PUMP_MISTING);
-      if(states[WARNING] == WARNING_MISTING)
-        states[WARNING] = NO_WARNING;
-    }
-    return;
-  }
-  #ifdef DEBUG
-    printf_P(PSTR("Misting: Info: Misting...\n\r"));
-  #endif
-  if(states[WARNING] == NO_WARNING) {
-    beep.play(TWO_BEEP);
-    states[WARNING] = WARNING_MISTING;
-    return;
-  }
-  startMisting--;
-  lastMisting = millis()/ONE_SEC;
-  relayOn(PUMP_MISTING);
-}
-
-void watering() {
-  // quick check
-  if(startWatering == 0) {
-    return;
-  }
-  // emergency stop
-  if(states[ERROR] == ERROR_NO_SUBSTRATE) {
-    #ifdef DEBUG
-      printf_P(PSTR("Watering: Error: Emergency stop watering.\n\r"));
-    #endif
-    relayOff(PUMP_WATERING);
-    return;    
-  }
-  // pause for cleanup pump and rest
-  uint8_t pauseDuration = 5;
-  if(states[WARNING] == WARNING_SUBSTRATE_LOW || 
-      states[WARNING] == INFO_SUBSTRATE_DELIVERED)
-    pauseDuration = 21; // max officient pause
-  // pause every 30 sec
-  if((millis()/ONE_SEC-startWatering) % 30 <= pauseDuration) {
-    #ifdef DEBUG
-      printf_P(PSTR("Watering: Info: Pause for clean up.\n\r"));
-    #endif
-    relayOff(PUMP_WATERING);
-    return;
-  }
-  // time is over
-  if(millis()/ONE_SEC-startWatering >= settings.wateringDuration*60) {
-    #ifdef DEBUG
-      printf_P(PSTR("Watering: Info: Stop watering.\n\r"));
-    #endif
-    relayOff(PUMP_WATERING);
-    startWatering = 0;
-    if(states[WARNING] == WARNING_WATERING) {
-      states[WARNING] = NO_WARNING;  
-    }
-    return;
-  }
-  // start watering
-  #ifdef DEBUG
-    printf_P(PSTR("Watering: Info: Watering...\n\r"));
-  #endif
-  if(states[WARNING] == NO_WARNING) {
-    beep.play(ONE_BEEP);
-    states[WARNING] = WARNING_WATERING;
-    return;
-  }
-  lastWatering = millis()/ONE_SEC;
-  relayOn(PUMP_WATERING);
-}
@@ -0,0 +1,90 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+// Arduino core for the host simulator. Time is simulated, pins and
+// registers are backed by the greenhouse model, see Simulator.h.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <avr/pgmspace.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#define ARDUINO 105
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef uint16_t word;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define A6 20
+#define A7 21
+
+#define F_CPU 16000000UL
+#define clockCyclesPerMicrosecond() (F_CPU/1000000L)
+
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+#define constrain(amt,low,high) \
+  ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bit(b) (1UL << (b))
+#define noInterrupts() cli()
+#define interrupts() sei()
+
+// binary.h constants used by libraries
+#define B00000001 1
+#define B00000010 2
+#define B00000100 4
+
+class __FlashStringHelper;
+#define F(string_literal) \
+  (reinterpret_cast<const __FlashStringHelper *>(PSTR(string_literal)))
+
+// Ports of pins as on the board: 0-7 PORTD, 8-13 PORTB, A0-A7 PORTC
+#define digitalPinToPort(pin) ((pin) < 8 ? 4 : (pin) < 14 ? 2 : 3)
+#define digitalPinToBitMask(pin) \
+  (1 << ((pin) < 8 ? (pin) : (pin) < 14 ? (pin) - 8 : (pin) - 14))
+#define portInputRegister(port) (&_MMIO_BYTE(0x23 + 3*((port) - 2)))
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+
+class HardwareSerial
+{
+public:
+  void begin(unsigned long baud) {}
+  size_t write(uint8_t c);
+  int available(void) { return 0; }
+  int read(void) { return -1; }
+};
+
+extern HardwareSerial Serial;
+
+#endif // __SIM_ARDUINO_H__
@@ -0,0 +1,2 @@
+// Sketch includes "Beep.h", the file is beep.h
+#include "../beep.h"
@@ -0,0 +1,354 @@
+// Drivers of bit-banged and interrupt driven hardware are replaced by
+// model readings. Headers are the sketch ones, so the sketch is built
+// as is. I2C devices run the real drivers on the simulated bus.
+
+#include "Simulator.h"
+#include "../DHT.h"
+#include "../DS18B20.h"
+#include "../AdcSampler.h"
+#include "../LowPower.h"
+#include "../TicklessIdle.h"
+#include "../Uptime.h"
+#include "../Watchdog.h"
+#include "../MemoryFree.h"
+
+/****************************************************************************/
+// DHT22, 0.1 resolution
+
+DHT::DHT(uint8_t pin, uint8_t type, uint8_t count)
+{
+  _pin = pin;
+  _type = type;
+  _count = count;
+}
+
+void DHT::begin(void)
+{
+}
+
+float DHT::readHumidity(void)
+{
+  float value = greenhouse.humidity +
+    greenhouse.sensorNoise(sim.unixtime(), 0);
+  return roundf(value*10)/10;
+}
+
+float DHT::readTemperature(bool S)
+{
+  float value = greenhouse.airTemp +
+    greenhouse.sensorNoise(sim.unixtime(), 1)*0.4f;
+  value = roundf(value*10)/10;
+  return S ? value*9/5 + 32 : value;
+}
+
+/****************************************************************************/
+// DS18B20, first sensor is inside of computer, second in substrate
+
+OneWire::OneWire(uint8_t pin)
+{
+}
+
+OneWireAsync::OneWireAsync(uint8_t pin)
+{
+}
+
+void OneWireAsync::begin(void)
+{
+}
+
+bool OneWireAsync::busy(void)
+{
+  return false;
+}
+
+DS18B20::DS18B20(OneWire *oneWire, OneWireAsync *engine)
+{
+  _oneWire = oneWire;
+  _engine = engine;
+  _count = 0;
+}
+
+bool DS18B20::begin(uint8_t quality, uint16_t eepromAddress,
+  uint8_t defaultRole)
+{
+  _quality = quality;
+  _eepromAddress = eepromAddress;
+  _count = 2;
+  for(uint8_t i = 0; i < _count; i++)
+    _sensors[i].role = defaultRole;
+  return true;
+}
+
+bool DS18B20::request(void)
+{
+  _beginConversionTime = millis();
+  return true;
+}
+
+bool DS18B20::available(void)
+{
+  return millis() - _beginConversionTime >= _conversionTime();
+}
+
+void DS18B20::update(void)
+{
+}
+
+uint16_t DS18B20::nextUpdate(void)
+{
+  return 0xFFFF;
+}
+
+uint16_t DS18B20::_conversionTime(void)
+{
+  return 750 >> (12 - _quality);
+}
+
+bool DS18B20::readAll(void)
+{
+  float values[2] = {greenhouse.computerTemp, greenhouse.substrateTemp};
+  // drop bits under resolution
+  uint8_t mask = ~((1 << (12 - _quality)) - 1);
+  for(uint8_t i = 0; i < _count; i++) {
+    float value = values[i] + greenhouse.sensorNoise(sim.unixtime(), 2+i)*0.2f;
+    _raw[i] = (int16_t)(value*16) & (int16_t)(int8_t)mask;
+  }
+  return true;
+}
+
+uint8_t DS18B20::count(void)
+{
+  return _count;
+}
+
+uint8_t DS18B20::roleCount(uint8_t role)
+{
+  uint8_t n = 0;
+  for(uint8_t i = 0; i < _count; i++)
+    n += _sensors[i].role == role;
+  return n;
+}
+
+void DS18B20::setRole(uint8_t index, uint8_t role)
+{
+  if(index < _count)
+    _sensors[index].role = role;
+}
+
+float DS18B20::temperature(uint8_t index)
+{
+  if(index >= _count)
+    return TEMP_ERROR;
+  return _raw[index]/16.0f;
+}
+
+float DS18B20::roleTemperature(uint8_t role)
+{
+  float sum = 0;
+  uint8_t n = 0;
+  for(uint8_t i = 0; i < _count; i++) {
+    if(_sensors[i].role != role)
+      continue;
+    sum += temperature(i);
+    n++;
+  }
+  return n == 0 ? TEMP_ERROR : sum/n;
+}
+
+/****************************************************************************/
+// Level sensors
+
+AdcSampler *AdcSampler::active = NULL;
+
+AdcSampler::AdcSampler(void)
+{
+  _count = 0;
+  _level = 0;
+}
+
+uint8_t AdcSampler::attach(uint8_t pin, uint16_t lowThreshold,
+  uint16_t highThreshold)
+{
+  if(_count >= ADC_MAX_CHANNELS)
+    return 0xFF;
+  _mux[_count] = pin;
+  _low[_count] = lowThreshold;
+  _high[_count] = highThreshold;
+  return _count++;
+}
+
+void AdcSampler::begin(void)
+{
+  active = this;
+}
+
+// Values are read from the model at once, there are no windows
+void AdcSampler::update(void)
+{
+}
+
+uint16_t AdcSampler::nextUpdate(void)
+{
+  return 0xFFFF;
+}
+
+uint16_t AdcSampler::value(uint8_t channel)
+{
+  return analogRead(_mux[channel]);
+}
+
+bool AdcSampler::isHigh(uint8_t channel)
+{
+  uint16_t raw = value(channel);
+  uint8_t bit = 1 << channel;
+  if(raw >= _high[channel])
+    _level |= bit;
+  else if(raw < _low[channel])
+    _level &= ~bit;
+  return _level & bit;
+}
+
+bool AdcSampler::ready(void)
+{
+  return true;
+}
+
+/****************************************************************************/
+// Sleep and watchdog
+
+LowPowerClass LowPower;
+
+static const uint32_t periodTime[] = {
+  15000, 30000, 60000, 120000, 250000, 500000,
+  1000000, 2000000, 4000000, 8000000
+};
+
+void LowPowerClass::powerDown(period_t period, short cycles, adc_t adc,
+  bod_t bod)
+{
+  if(period < SLEEP_FOREVER)
+    sim.sleep((uint64_t)periodTime[period]*cycles);
+}
+
+// Uptime follows CPU time, power down is compensated by TicklessIdle
+
+Uptime uptime;
+
+Uptime::Uptime(void)
+{
+}
+
+void Uptime::begin(void)
+{
+}
+
+uint64_t Uptime::ticks(void)
+{
+  return sim.cpuTime*2;
+}
+
+unsigned long Uptime::seconds(void)
+{
+  return sim.cpuTime/1000000;
+}
+
+unsigned long Uptime::minutes(void)
+{
+  return sim.cpuTime/60000000;
+}
+
+uint16_t Uptime::toNextSecond(void)
+{
+  return 1000 - sim.cpuTime/1000%1000;
+}
+
+void Uptime::advance(uint16_t ms)
+{
+}
+
+void Uptime::handleInterrupt(void)
+{
+}
+
+/****************************************************************************/
+// Tickless idle, the simulated CPU sleeps till the deadline at once
+
+TicklessIdle *TicklessIdle::active = NULL;
+
+TicklessIdle::TicklessIdle(void)
+{
+  _span = IDLE_MAX_SLEEP;
+  _sleepTime = 0;
+  _sleeps = 0;
+  _statsStart = 0;
+}
+
+bool TicklessIdle::attach(uint8_t pin)
+{
+  return A0 <= pin && pin <= A5;
+}
+
+void TicklessIdle::begin(void)
+{
+  _statsStart = millis();
+}
+
+void TicklessIdle::wakeIn(uint16_t ms)
+{
+  if(ms < _span)
+    _span = ms;
+}
+
+void TicklessIdle::hold(void)
+{
+  _span = 0;
+}
+
+void TicklessIdle::sleep(void)
+{
+  uint16_t span = _span;
+  _span = IDLE_MAX_SLEEP;
+  if(span < IDLE_MIN_SLEEP)
+    return;
+  _sleeps++;
+  _sleepTime += span;
+  sim.idle((uint64_t)span*1000);
+}
+
+void TicklessIdle::compensate(uint16_t ms)
+{
+  _sleepTime += ms;
+  sim.cpuTime += (uint64_t)ms*1000;
+}
+
+void TicklessIdle::stats(uint8_t *percent, uint16_t *sleeps)
+{
+  unsigned long now = millis();
+  unsigned long total = now - _statsStart;
+  *percent = total == 0 ? 0 : min(_sleepTime*100/total, 100);
+  *sleeps = _sleeps;
+  _statsStart = now;
+  _sleepTime = 0;
+  _sleeps = 0;
+}
+
+void TicklessIdle::handleInterrupt(void)
+{
+}
+
+void softResetMem(int bytes)
+{
+}
+
+void softResetTimeout()
+{
+}
+
+void heartbeat()
+{
+}
+
+int freeMemory()
+{
+  return 800;
+}
@@ -0,0 +1,142 @@
+#include "Greenhouse.h"
+#include <math.h>
+
+void Greenhouse::begin(uint32_t _seed, uint32_t unixtime)
+{
+  seed = _seed;
+  airTemp = outdoorTemp(unixtime);
+  humidity = 60;
+  substrateTemp = tankTemp = airTemp - 1;
+  computerTemp = airTemp + 9;
+  lux = sunLux(unixtime);
+  moisture = MOISTURE_CAPACITY*0.6f;
+  runoff = 0;
+  substrateTank = SUBSTRATE_TANK;
+  waterTank = WATER_TANK;
+}
+
+// Uniform 0-1 by key, it doesn't depend on order of calls
+float Greenhouse::random(uint32_t key, uint8_t channel)
+{
+  uint32_t x = seed*2654435761u ^ key*2246822519u ^ channel*3266489917u;
+  x ^= x >> 15;
+  x *= 2246822519u;
+  x ^= x >> 13;
+  x *= 3266489917u;
+  x ^= x >> 16;
+  return (x & 0xFFFFFF)/16777216.0f;
+}
+
+float Greenhouse::outdoorTemp(uint32_t unixtime)
+{
+  float hour = (unixtime % 86400)/3600.0f;
+  // warm and cold days
+  float offset = random(unixtime/86400, 0)*6 - 3;
+  return 20 + offset + 6*sinf(2*M_PI*(hour-9)/24);
+}
+
+float Greenhouse::sunLux(uint32_t unixtime)
+{
+  float hour = (unixtime % 86400)/3600.0f;
+  if(hour < 6 || hour > 19)
+    return 0;
+  // clouds of the day and passing ones
+  uint32_t day = unixtime/86400;
+  float cloud = 0.35f + 0.65f*random(day, 1);
+  float passing = 0.8f + 0.2f*sinf(hour*1.7f + random(day, 2)*6);
+  return 30000*sinf(M_PI*(hour-6)/13)*cloud*passing;
+}
+
+void Greenhouse::step(uint32_t unixtime, bool misting, bool watering,
+  bool lamp)
+{
+  float hour = (unixtime % 86400)/3600.0f;
+  float sun = sunLux(unixtime);
+  lux = sun + (lamp ? 12000 : 0);
+  // air is heated by sun and lamp
+  float airTarget = outdoorTemp(unixtime) + 5*sun/30000 + (lamp ? 2.5f : 0);
+  airTemp += (airTarget - airTemp)/1800;
+  computerTemp = airTemp + 9;
+  // humidity is higher at night, plants transpire in light
+  float wet = moisture/MOISTURE_CAPACITY;
+  float humidityTarget = 55 + 15*cosf(2*M_PI*(hour-5)/24) +
+    8*lux/30000*wet - 1.5f*(airTemp-20);
+  humidityTarget = fminf(fmaxf(humidityTarget, 20), 95);
+  humidity += (humidityTarget - humidity)/1200;
+  if(misting && waterTank > 0) {
+    humidity = fminf(humidity + 0.9f, 99);
+    waterTank -= MISTING_FLOW;
+    waterUsed += MISTING_FLOW;
+  }
+  // substrate soaks pumped water, the rest runs to drain
+  if(watering && substrateTank > 0) {
+    float absorbed = WATERING_FLOW*(1 - powf(wet, 4));
+    moisture += absorbed;
+    runoff += WATERING_FLOW - absorbed;
+    substrateTank -= WATERING_FLOW;
+    substratePumped += WATERING_FLOW;
+    substrateTemp += (tankTemp - substrateTemp)*WATERING_FLOW/
+      (moisture + 500);
+  }
+  float drain = runoff*0.05f;
+  runoff -= drain;
+  substrateTank += drain;
+  // uptake by plants and evaporation
+  moisture -= wet*(0.004f + 0.025f*lux/30000*fmaxf(airTemp, 5)/25);
+  if(moisture < 0)
+    moisture = 0;
+  substrateTemp += (airTemp - 1 - substrateTemp)/3600;
+  tankTemp += (outdoorTemp(unixtime) - 1 - tankTemp)/20000;
+  refill(unixtime);
+  // counters
+  wateringSeconds += watering;
+  mistingSeconds += misting;
+  lampSeconds += lamp;
+  wateringStarts += watering && lastWatering == false;
+  mistingStarts += misting && lastMisting == false;
+  lampStarts += lamp && lastLamp == false;
+  lastWatering = watering;
+  lastMisting = misting;
+  lastLamp = lamp;
+}
+
+// Somebody looks at tanks every morning at 10:00
+void Greenhouse::refill(uint32_t unixtime)
+{
+  if(unixtime % 86400 != 10*3600L)
+    return;
+  if(substrateTank < SUBSTRATE_TANK/4) {
+    substrateTank = SUBSTRATE_TANK;
+    refills++;
+  }
+  if(waterTank < WATER_TANK/4) {
+    waterTank = WATER_TANK;
+    refills++;
+  }
+}
+
+float Greenhouse::sensorNoise(uint32_t unixtime, uint8_t channel)
+{
+  return random(unixtime, channel+8) - 0.5f;
+}
+
+bool Greenhouse::substrateDelivered(void)
+{
+  return runoff > 100;
+}
+
+bool Greenhouse::substrateFull(void)
+{
+  return substrateTank > SUBSTRATE_TANK*0.97f;
+}
+
+// Level sensors give 900 for empty and 100 for full tank
+uint16_t Greenhouse::substrateLevelRaw(void)
+{
+  return 900 - 800*fmaxf(substrateTank, 0)/SUBSTRATE_TANK;
+}
+
+uint16_t Greenhouse::waterLevelRaw(void)
+{
+  return 900 - 800*fmaxf(waterTank, 0)/WATER_TANK;
+}
@@ -0,0 +1,56 @@
+#ifndef GREENHOUSE_H
+#define GREENHOUSE_H
+
+#include <stdint.h>
+
+// Water in substrate and tanks, ml
+static const float MOISTURE_CAPACITY = 1500;
+static const float SUBSTRATE_TANK = 20000;
+static const float WATER_TANK = 5000;
+// Flow of pumps, ml per second
+static const float WATERING_FLOW = 40;
+static const float MISTING_FLOW = 6;
+// Power of loads, W
+static const float WATERING_POWER = 12;
+static const float MISTING_POWER = 8;
+static const float LAMP_POWER = 36;
+
+// Plant and environment model of the grow box. It is stepped once a
+// simulated second with relay outputs and gives values for the sensors.
+// Weather of every day is drawn from the seed, so runs are repeatable.
+class Greenhouse
+{
+public:
+  float airTemp, humidity; // C, %
+  float substrateTemp, tankTemp, computerTemp; // C
+  float lux; // at light sensor
+  float moisture; // water kept in substrate, ml
+  float runoff; // free water flowing to drain, ml
+  float substrateTank, waterTank; // ml
+  // counters
+  uint32_t wateringSeconds, mistingSeconds, lampSeconds;
+  uint32_t wateringStarts, mistingStarts, lampStarts;
+  float substratePumped, waterUsed; // ml
+  uint16_t refills;
+
+  void begin(uint32_t seed, uint32_t unixtime);
+  void step(uint32_t unixtime, bool misting, bool watering, bool lamp);
+
+  // Sensors
+  float sensorNoise(uint32_t unixtime, uint8_t channel);
+  bool substrateDelivered(void);
+  bool substrateFull(void);
+  uint16_t substrateLevelRaw(void);
+  uint16_t waterLevelRaw(void);
+
+private:
+  uint32_t seed;
+  bool lastMisting, lastWatering, lastLamp;
+
+  float random(uint32_t key, uint8_t channel);
+  float outdoorTemp(uint32_t unixtime);
+  float sunLux(uint32_t unixtime);
+  void refill(uint32_t unixtime);
+};
+
+#endif // __GREENHOUSE_H__
@@ -0,0 +1,268 @@
+// Closed loop run of the sketch in the greenhouse model.
+// Prototypes are generated by build.sh like Arduino IDE does.
+
+#include <Arduino.h>
+#include <unistd.h>
+#include "Simulator.h"
+#include "Sweep.h"
+#include "prototypes.h"
+#include "../hydroponics.ino"
+
+// Key performance indicators
+struct Kpi {
+  uint32_t seconds;
+  uint32_t humidityInRange, airInRange, substrateInRange;
+  uint32_t substrateDry; // moisture under 30%
+  double humiditySum, humiditySquares;
+  uint32_t alarmActive;
+  uint16_t alarmRaises[ALARM_CODES];
+} kpi;
+
+// Climate is rated by default ranges, so sweeps of ranges are fair
+static const SettingsStruct targets = settings;
+
+void collect(void)
+{
+  kpi.seconds++;
+  float humidity = greenhouse.humidity;
+  kpi.humidityInRange += targets.humidMinimum <= humidity &&
+    humidity <= targets.humidMaximum;
+  kpi.airInRange += targets.airTempMinimum <= greenhouse.airTemp &&
+    greenhouse.airTemp <= targets.airTempMaximum;
+  kpi.substrateInRange += greenhouse.substrateTemp > targets.subsTempMinimum;
+  kpi.substrateDry += greenhouse.moisture < MOISTURE_CAPACITY*0.3f;
+  kpi.humiditySum += humidity;
+  kpi.humiditySquares += humidity*humidity;
+  // count raises of every alarm
+  uint32_t raised = alarms.active & ~kpi.alarmActive;
+  for(uint8_t code = 0; code < ALARM_CODES; code++)
+    kpi.alarmRaises[code] += (raised >> code) & 1;
+  kpi.alarmActive = alarms.active;
+}
+
+static float percent(uint32_t part)
+{
+  return kpi.seconds == 0 ? 0 : 100.0f*part/kpi.seconds;
+}
+
+void report(void)
+{
+  double mean = kpi.humiditySum/kpi.seconds;
+  double variance = kpi.humiditySquares/kpi.seconds - mean*mean;
+  printf("days %.1f\n", kpi.seconds/86400.0);
+  printf("humidity_in_range %.1f%%\n", percent(kpi.humidityInRange));
+  printf("humidity_mean %.1f%%\n", mean);
+  printf("humidity_stddev %.2f%%\n", sqrt(variance > 0 ? variance : 0));
+  printf("air_in_range %.1f%%\n", percent(kpi.airInRange));
+  printf("substrate_temp_in_range %.1f%%\n", percent(kpi.substrateInRange));
+  printf("substrate_dry %.1f%%\n", percent(kpi.substrateDry));
+  printf("watering_pump %lu s, %lu starts, %.1f Wh\n",
+    (unsigned long)greenhouse.wateringSeconds,
+    (unsigned long)greenhouse.wateringStarts,
+    greenhouse.wateringSeconds*WATERING_POWER/3600);
+  printf("misting_pump %lu s, %lu starts, %.1f Wh\n",
+    (unsigned long)greenhouse.mistingSeconds,
+    (unsigned long)greenhouse.mistingStarts,
+    greenhouse.mistingSeconds*MISTING_POWER/3600);
+  printf("lamp %.1f h, %lu starts, %.1f Wh\n",
+    greenhouse.lampSeconds/3600.0, (unsigned long)greenhouse.lampStarts,
+    greenhouse.lampSeconds*LAMP_POWER/3600);
+  printf("substrate_pumped %.1f l\n", greenhouse.substratePumped/1000);
+  printf("mist_water_used %.1f l\n", greenhouse.waterUsed/1000);
+  printf("tank_refills %u\n", greenhouse.refills);
+  printf("sleep %.1f h\n", sim.sleepTime/3600e6);
+  printf("idle %.1f%%\n", 100.0*sim.idleTime/sim.wallTime);
+  printf("tones %u\n", sim.tones);
+  uint32_t records = historyLog.rawBytes/
+    (historyLog.series()*sizeof(uint16_t));
+  if(records)
+    printf("history_log %lu records, %.1f bytes/record, %.0f%% of raw\n",
+      (unsigned long)records, (double)historyLog.encodedBytes/records,
+      100.0*historyLog.encodedBytes/historyLog.rawBytes);
+  for(uint8_t code = 0; code < ALARM_CODES; code++) {
+    if(kpi.alarmRaises[code])
+      printf("alarm_%u %u\n", code, kpi.alarmRaises[code]);
+  }
+}
+
+// Settings which can be set or swept by name
+struct Knob {
+  const char *name;
+  void *value;
+  uint8_t size;
+};
+
+#define KNOB(name, field) {name, &settings.field, sizeof(settings.field)}
+static const Knob knobs[] = {
+  KNOB("wateringDuration", zones[0].wateringDuration),
+  KNOB("wateringSunnyPeriod", zones[0].wateringSunnyPeriod),
+  KNOB("wateringPeriod", zones[0].wateringPeriod),
+  KNOB("mistingDuration", zones[0].mistingDuration),
+  KNOB("mistingSunnyPeriod", zones[0].mistingSunnyPeriod),
+  KNOB("mistingPeriod", zones[0].mistingPeriod),
+  KNOB("lightMinimum", lightMinimum),
+  KNOB("lightDayStart", lightDayStart),
+  KNOB("lightDayDuration", lightDayDuration),
+  KNOB("humidMinimum", humidMinimum),
+  KNOB("humidMaximum", humidMaximum),
+  KNOB("airTempMinimum", airTempMinimum),
+  KNOB("airTempMaximum", airTempMaximum),
+  KNOB("subsTempMinimum", subsTempMinimum),
+  KNOB("silentEvening", silentEvening),
+  KNOB("silentMorning", silentMorning),
+  KNOB("profile", profile),
+  KNOB("profileDay", profileDay)
+};
+static const uint8_t KNOBS = sizeof(knobs)/sizeof(Knob);
+
+static const Knob *findKnob(const char *name, size_t length)
+{
+  for(uint8_t k = 0; k < KNOBS; k++) {
+    if(strlen(knobs[k].name) == length &&
+        strncmp(knobs[k].name, name, length) == 0)
+      return &knobs[k];
+  }
+  fprintf(stderr, "Unknown setting '%.*s'\n", (int)length, name);
+  exit(1);
+}
+
+static void setKnob(const Knob *knob, uint16_t value)
+{
+  if(knob->size == 1)
+    *(uint8_t *)knob->value = value;
+  else
+    *(uint16_t *)knob->value = value;
+}
+
+// Run options
+static float days = 14;
+static uint32_t seed = 1;
+static uint32_t start = 1459468800; // 2016-04-01 00:00
+static uint32_t loopTime = 50000; // us per loop() call
+static bool blank = false;
+
+static void simulate(void)
+{
+  sim.begin(seed, start);
+  sim.onSecond = collect;
+  // device was set up before, settings are in EEPROM
+  if(blank == false)
+    eeprom_update_block(&settings, (void *)0, sizeof(settings));
+  setup();
+  uint64_t end = (uint64_t)(days*86400)*1000000;
+  while(sim.wallTime < end) {
+    loop();
+    sim.advance(loopTime);
+  }
+}
+
+// Swept settings and run of a point in forked process
+static SweepParameter sweepParameters[SWEEP_MAX_PARAMETERS];
+static const Knob *sweepKnobs[SWEEP_MAX_PARAMETERS];
+static uint8_t sweepCount;
+
+static bool sweepRun(const uint16_t *values, float *objectives)
+{
+  for(uint8_t p = 0; p < sweepCount; p++)
+    setKnob(sweepKnobs[p], values[p]);
+  simulate();
+  objectives[0] = (greenhouse.substratePumped + greenhouse.waterUsed)/1000;
+  objectives[1] = (greenhouse.wateringSeconds*WATERING_POWER +
+    greenhouse.mistingSeconds*MISTING_POWER +
+    greenhouse.lampSeconds*LAMP_POWER)/3600;
+  // average of time out of range, dry substrate counts too
+  objectives[2] = 100 - (percent(kpi.humidityInRange) +
+    percent(kpi.airInRange) + percent(kpi.substrateInRange) +
+    100 - percent(kpi.substrateDry))/4;
+  return true;
+}
+
+static void usage(void)
+{
+  printf("Usage: hydroponics-sim [-d days] [-s seed] [-t unixtime] "
+    "[-l loop_us] [-e] [-v]\n"
+    "         [-p name=value]... [-P name=min:max[:step]]... "
+    "[-r samples] [-j jobs] [-a]\n");
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t samples = 0;
+  // parallel runs are 1..255
+  uint8_t jobs = constrain(sysconf(_SC_NPROCESSORS_ONLN), 1, 255);
+  bool all = false;
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "-v") == 0) {
+      sim.verbose = true;
+      continue;
+    }
+    if(strcmp(argv[i], "-e") == 0) {
+      blank = true;
+      continue;
+    }
+    if(strcmp(argv[i], "-a") == 0) {
+      all = true;
+      continue;
+    }
+    if(i+1 >= argc) {
+      usage();
+      return 1;
+    }
+    const char *value = argv[++i];
+    if(strcmp(argv[i-1], "-d") == 0)
+      days = atof(value);
+    else if(strcmp(argv[i-1], "-s") == 0)
+      seed = strtoul(value, NULL, 0);
+    else if(strcmp(argv[i-1], "-t") == 0)
+      start = strtoul(value, NULL, 0);
+    else if(strcmp(argv[i-1], "-l") == 0)
+      loopTime = strtoul(value, NULL, 0);
+    else if(strcmp(argv[i-1], "-r") == 0)
+      samples = strtoul(value, NULL, 0);
+    else if(strcmp(argv[i-1], "-j") == 0)
+      jobs = constrain(atoi(value), 1, 255);
+    else if(strcmp(argv[i-1], "-p") == 0) {
+      const char *equal = strchr(value, '=');
+      if(equal == NULL) {
+        usage();
+        return 1;
+      }
+      setKnob(findKnob(value, equal-value), atoi(equal+1));
+    }
+    else if(strcmp(argv[i-1], "-P") == 0) {
+      const char *equal = strchr(value, '=');
+      if(equal == NULL || sweepCount >= SWEEP_MAX_PARAMETERS) {
+        usage();
+        return 1;
+      }
+      SweepParameter *parameter = &sweepParameters[sweepCount];
+      sweepKnobs[sweepCount++] = findKnob(value, equal-value);
+      parameter->name = sweepKnobs[sweepCount-1]->name;
+      parameter->step = 1;
+      if(sscanf(equal+1, "%hu:%hu:%hu", &parameter->minimum,
+          &parameter->maximum, &parameter->step) < 2 ||
+          parameter->maximum < parameter->minimum) {
+        usage();
+        return 1;
+      }
+    }
+    else {
+      usage();
+      return 1;
+    }
+  }
+  if(sweepCount == 0) {
+    simulate();
+    report();
+    return 0;
+  }
+  Sweep sweep(sweepParameters, sweepCount, sweepRun);
+  if(samples > 0)
+    sweep.random(samples, seed, jobs);
+  else
+    sweep.grid(jobs);
+  uint32_t front = sweep.pareto();
+  fprintf(stderr, "%u Pareto optimal settings\n", front);
+  sweep.report(all);
+  return 0;
+}
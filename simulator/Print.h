@@ -0,0 +1,27 @@
+#ifndef SIM_PRINT_H
+#define SIM_PRINT_H
+
+#include <Arduino.h>
+
+class Print
+{
+public:
+  virtual size_t write(uint8_t) = 0;
+
+  size_t write(const char *str) {
+    return str == NULL ? 0 : write((const uint8_t *)str, strlen(str));
+  }
+
+  virtual size_t write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while(size--)
+      n += write(*buffer++);
+    return n;
+  }
+
+  size_t print(const char *str) {
+    return write(str);
+  }
+};
+
+#endif // __SIM_PRINT_H__
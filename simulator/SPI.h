@@ -0,0 +1,15 @@
+#ifndef SIM_SPI_H
+#define SIM_SPI_H
+
+#include <Arduino.h>
+
+class SPIClass
+{
+public:
+  static void begin(void) {}
+  static uint8_t transfer(uint8_t data) { return 0; }
+};
+
+extern SPIClass SPI;
+
+#endif // __SIM_SPI_H__
@@ -0,0 +1,295 @@
+#include <stdio.h>
+#include <stdarg.h>
+
+// Host streams, the sketch points its stdout to Serial
+FILE *sim_stdout = stdout, *sim_stderr = stderr;
+
+#include "Simulator.h"
+#include <Wire.h>
+#include <SPI.h>
+#include <avr/eeprom.h>
+#include "../RTClib.h"
+
+Simulator sim;
+Greenhouse greenhouse;
+HardwareSerial Serial;
+TwoWire Wire;
+SPIClass SPI;
+
+volatile uint8_t sim_io[0x100];
+static uint8_t eeprom[E2END+1];
+
+void Simulator::begin(uint32_t seed, uint32_t unixtime)
+{
+  startTime = unixtime;
+  memset(eeprom, 0xFF, sizeof(eeprom));
+  // pull-ups keep relays off till the sketch takes the pins
+  PORTD = 0xFF;
+  greenhouse.begin(seed, unixtime);
+  nextSecond = 1000000;
+}
+
+void Simulator::advance(uint64_t us)
+{
+  wallTime += us;
+  cpuTime += us;
+  run();
+}
+
+void Simulator::sleep(uint64_t us)
+{
+  wallTime += us;
+  sleepTime += us;
+  run();
+}
+
+void Simulator::idle(uint64_t us)
+{
+  wallTime += us;
+  cpuTime += us;
+  idleTime += us;
+  run();
+}
+
+void Simulator::run(void)
+{
+  while(wallTime >= nextSecond) {
+    nextSecond += 1000000;
+    greenhouse.step(unixtime(), relay(SIM_MISTING_PIN),
+      relay(SIM_WATERING_PIN), relay(SIM_LAMP_PIN));
+    if(onSecond)
+      onSecond();
+  }
+}
+
+uint32_t Simulator::unixtime(void)
+{
+  return startTime + wallTime/1000000;
+}
+
+bool Simulator::relay(uint8_t pin)
+{
+  uint8_t mask = _BV(pin);
+  return (DDRD & mask) && (PORTD & mask) == 0;
+}
+
+/****************************************************************************/
+// Arduino core
+
+int sim_printf(const char *format, ...)
+{
+  if(sim.verbose == false)
+    return 0;
+  va_list args;
+  va_start(args, format);
+  int n = vprintf(format, args);
+  va_end(args);
+  return n;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  if(sim.verbose && c != '\r')
+    putchar(c);
+  return 1;
+}
+
+unsigned long millis(void)
+{
+  return (uint32_t)(sim.cpuTime/1000);
+}
+
+unsigned long micros(void)
+{
+  return (uint32_t)sim.cpuTime;
+}
+
+void delay(unsigned long ms)
+{
+  sim.advance((uint64_t)ms*1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  sim.advance(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+}
+
+int digitalRead(uint8_t pin)
+{
+  switch(pin) {
+    case SIM_SUBSTRATE_FULL_PIN:
+      return greenhouse.substrateFull();
+    case SIM_DELIVERED_PIN:
+      return greenhouse.substrateDelivered();
+  }
+  // buttons and the rest are pulled up
+  return HIGH;
+}
+
+int analogRead(uint8_t pin)
+{
+  switch(pin) {
+    case SIM_WATER_LEVEL_PIN:
+      return greenhouse.waterLevelRaw();
+    case SIM_SUBSTRATE_LEVEL_PIN:
+      return greenhouse.substrateLevelRaw();
+  }
+  return 0;
+}
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration)
+{
+  sim.tones++;
+}
+
+void noTone(uint8_t pin)
+{
+}
+
+/****************************************************************************/
+// EEPROM
+
+uint8_t eeprom_read_byte(const uint8_t *address)
+{
+  return eeprom[(uintptr_t)address % sizeof(eeprom)];
+}
+
+void eeprom_write_byte(uint8_t *address, uint8_t value)
+{
+  eeprom[(uintptr_t)address % sizeof(eeprom)] = value;
+}
+
+void eeprom_update_byte(uint8_t *address, uint8_t value)
+{
+  eeprom_write_byte(address, value);
+}
+
+void eeprom_read_block(void *destination, const void *source, size_t size)
+{
+  for(size_t i = 0; i < size; i++)
+    ((uint8_t *)destination)[i] =
+      eeprom_read_byte((const uint8_t *)source + i);
+}
+
+void eeprom_update_block(const void *source, void *destination, size_t size)
+{
+  for(size_t i = 0; i < size; i++)
+    eeprom_write_byte((uint8_t *)destination + i, ((const uint8_t *)source)[i]);
+}
+
+/****************************************************************************/
+// I2C devices
+
+static const uint8_t DS1307_ADDRESS = 0x68;
+static const uint8_t BH1750_ADDRESS = 0x23;
+static uint8_t ds1307Pointer;
+static uint8_t ds1307Ram[64];
+static int32_t ds1307Offset; // seconds set by adjust
+
+static uint8_t bin2bcd(uint8_t value)
+{
+  return value + 6*(value/10);
+}
+
+static uint8_t bcd2bin(uint8_t value)
+{
+  return value - 6*(value >> 4);
+}
+
+// Clock registers from wall time, other ones are in RAM
+static uint8_t ds1307Read(uint8_t reg)
+{
+  if(reg >= 7)
+    return ds1307Ram[reg & 63];
+  DateTime now(sim.unixtime() + ds1307Offset);
+  switch(reg) {
+    case 0: return bin2bcd(now.second());
+    case 1: return bin2bcd(now.minute());
+    case 2: return bin2bcd(now.hour());
+    case 3: return bin2bcd(now.dayOfWeek()+1);
+    case 4: return bin2bcd(now.day());
+    case 5: return bin2bcd(now.month());
+  }
+  return bin2bcd(now.year()-2000);
+}
+
+static void ds1307Write(const uint8_t *data, uint8_t count)
+{
+  if(count == 0)
+    return;
+  ds1307Pointer = data[0];
+  if(ds1307Pointer == 0 && count >= 8) {
+    // adjust
+    DateTime time(2000 + bcd2bin(data[7]), bcd2bin(data[6]),
+      bcd2bin(data[5]), bcd2bin(data[3]), bcd2bin(data[2]),
+      bcd2bin(data[1] & 0x7F));
+    ds1307Offset = time.unixtime() - sim.unixtime();
+    return;
+  }
+  for(uint8_t i = 1; i < count; i++)
+    ds1307Ram[(ds1307Pointer++) & 63] = data[i];
+}
+
+void TwoWire::beginTransmission(uint8_t _address)
+{
+  address = _address;
+  txCount = 0;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+  if(txCount < sizeof(txBuffer))
+    txBuffer[txCount++] = data;
+  return 1;
+}
+
+uint8_t TwoWire::endTransmission(void)
+{
+  if(address == DS1307_ADDRESS)
+    ds1307Write(txBuffer, txCount);
+  txCount = 0;
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t _address, uint8_t quantity)
+{
+  rxCount = min(quantity, sizeof(rxBuffer));
+  rxIndex = 0;
+  for(uint8_t i = 0; i < rxCount; i++) {
+    switch(_address) {
+      case DS1307_ADDRESS:
+        rxBuffer[i] = ds1307Read(ds1307Pointer++);
+        break;
+      case BH1750_ADDRESS: {
+        // raw value is 1.2 counts per lux, 0xFFFF is an error
+        uint32_t raw = greenhouse.lux*1.2f;
+        raw = min(raw, 0xFFFEu);
+        rxBuffer[i] = i == 0 ? raw >> 8 : raw & 0xFF;
+        break;
+      }
+      default:
+        rxBuffer[i] = 0xFF;
+    }
+  }
+  return rxCount;
+}
+
+int TwoWire::available(void)
+{
+  return rxCount - rxIndex;
+}
+
+int TwoWire::read(void)
+{
+  if(rxIndex >= rxCount)
+    return -1;
+  return rxBuffer[rxIndex++];
+}
@@ -0,0 +1,53 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <Arduino.h>
+#include "Greenhouse.h"
+
+// Pins of the sketch wired to the model
+static const uint8_t SIM_WATERING_PIN = 4;
+static const uint8_t SIM_MISTING_PIN = 5;
+static const uint8_t SIM_LAMP_PIN = 7;
+static const uint8_t SIM_SUBSTRATE_FULL_PIN = A0;
+static const uint8_t SIM_DELIVERED_PIN = A1;
+static const uint8_t SIM_WATER_LEVEL_PIN = A6;
+static const uint8_t SIM_SUBSTRATE_LEVEL_PIN = A7;
+
+// Simulated time and hardware around the sketch. Wall time runs the
+// model and the clock chip, CPU time is what millis() sees, it stops
+// while the MCU is powered down like Timer0 does. Idle time is kept
+// by millis(), the tickless idle compensates it.
+class Simulator
+{
+public:
+  uint64_t wallTime; // us from start
+  uint64_t cpuTime; // us
+  uint64_t sleepTime; // us
+  uint64_t idleTime; // us
+  uint32_t startTime; // unixtime
+  bool verbose;
+  uint32_t tones;
+  // called after every simulated second
+  void (*onSecond)(void);
+
+  void begin(uint32_t seed, uint32_t unixtime);
+  // CPU is running
+  void advance(uint64_t us);
+  // CPU is powered down
+  void sleep(uint64_t us);
+  // CPU is in idle mode
+  void idle(uint64_t us);
+  uint32_t unixtime(void);
+  // Relay output is on, relays are active low
+  bool relay(uint8_t pin);
+
+private:
+  uint64_t nextSecond;
+
+  void run(void);
+};
+
+extern Simulator sim;
+extern Greenhouse greenhouse;
+
+#endif // __SIMULATOR_H__
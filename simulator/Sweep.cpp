@@ -0,0 +1,186 @@
+#include "Sweep.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+static const char *objectiveNames[SWEEP_OBJECTIVES] = {
+  "water_l", "energy_wh", "climate_out_%"
+};
+
+Sweep::Sweep(const SweepParameter *_parameters, uint8_t _count,
+  SweepRun _run)
+{
+  parameters = _parameters;
+  count = _count < SWEEP_MAX_PARAMETERS ? _count : SWEEP_MAX_PARAMETERS;
+  run = _run;
+  results = NULL;
+  size = 0;
+}
+
+Sweep::~Sweep()
+{
+  free(results);
+}
+
+static uint16_t steps(const SweepParameter *parameter)
+{
+  uint16_t step = parameter->step ? parameter->step : 1;
+  return (parameter->maximum - parameter->minimum)/step + 1;
+}
+
+uint32_t Sweep::grid(uint8_t jobs)
+{
+  size = 1;
+  for(uint8_t p = 0; p < count; p++)
+    size *= steps(&parameters[p]);
+  results = (SweepResult *)calloc(size, sizeof(SweepResult));
+  // mixed radix counter over parameter steps
+  for(uint32_t i = 0; i < size; i++) {
+    uint32_t index = i;
+    for(uint8_t p = 0; p < count; p++) {
+      uint16_t n = steps(&parameters[p]);
+      uint16_t step = parameters[p].step ? parameters[p].step : 1;
+      results[i].values[p] = parameters[p].minimum + (index % n)*step;
+      index /= n;
+    }
+  }
+  return execute(jobs);
+}
+
+uint32_t Sweep::random(uint32_t samples, uint32_t seed, uint8_t jobs)
+{
+  size = samples;
+  results = (SweepResult *)calloc(size, sizeof(SweepResult));
+  uint32_t x = seed ? seed : 1;
+  for(uint32_t i = 0; i < size; i++) {
+    for(uint8_t p = 0; p < count; p++) {
+      // xorshift32
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      uint16_t step = parameters[p].step ? parameters[p].step : 1;
+      results[i].values[p] = parameters[p].minimum +
+        (x % steps(&parameters[p]))*step;
+    }
+  }
+  return execute(jobs);
+}
+
+// Fork pool, results come back by pipes
+uint32_t Sweep::execute(uint8_t jobs)
+{
+  pid_t *pids = (pid_t *)calloc(jobs, sizeof(pid_t));
+  int *pipes = (int *)calloc(jobs, sizeof(int));
+  uint32_t *points = (uint32_t *)calloc(jobs, sizeof(uint32_t));
+  uint32_t next = 0, done = 0;
+  fflush(stdout);
+  while(done < size) {
+    // start new runs
+    for(uint8_t j = 0; j < jobs && next < size; j++) {
+      if(pids[j] != 0)
+        continue;
+      int fd[2];
+      if(pipe(fd) != 0) {
+        perror("pipe");
+        exit(1);
+      }
+      pid_t pid = fork();
+      if(pid < 0) {
+        perror("fork");
+        exit(1);
+      }
+      if(pid == 0) {
+        close(fd[0]);
+        float objectives[SWEEP_OBJECTIVES];
+        bool ok = run(results[next].values, objectives);
+        if(ok && write(fd[1], objectives, sizeof(objectives)) < 0)
+          _exit(1);
+        _exit(ok ? 0 : 1);
+      }
+      close(fd[1]);
+      pids[j] = pid;
+      pipes[j] = fd[0];
+      points[j] = next++;
+    }
+    // collect finished one
+    int status;
+    pid_t pid = wait(&status);
+    if(pid < 0) {
+      if(errno == EINTR)
+        continue;
+      // no run is left to wait for
+      perror("wait");
+      break;
+    }
+    for(uint8_t j = 0; j < jobs; j++) {
+      if(pids[j] != pid)
+        continue;
+      SweepResult *result = &results[points[j]];
+      ssize_t n = read(pipes[j], result->objectives,
+        sizeof(result->objectives));
+      if(n != sizeof(result->objectives)) {
+        // failed run is never optimal
+        for(uint8_t o = 0; o < SWEEP_OBJECTIVES; o++)
+          result->objectives[o] = 1e30f;
+      }
+      close(pipes[j]);
+      pids[j] = 0;
+      done++;
+      fprintf(stderr, "\r%u/%u", done, size);
+    }
+  }
+  fprintf(stderr, "\n");
+  free(pids);
+  free(pipes);
+  free(points);
+  return done;
+}
+
+static bool dominates(const SweepResult *a, const SweepResult *b)
+{
+  bool better = false;
+  for(uint8_t o = 0; o < SWEEP_OBJECTIVES; o++) {
+    if(a->objectives[o] > b->objectives[o])
+      return false;
+    if(a->objectives[o] < b->objectives[o])
+      better = true;
+  }
+  return better;
+}
+
+uint32_t Sweep::pareto(void)
+{
+  uint32_t front = 0;
+  for(uint32_t i = 0; i < size; i++) {
+    results[i].dominated = false;
+    for(uint32_t j = 0; j < size; j++) {
+      if(j != i && dominates(&results[j], &results[i])) {
+        results[i].dominated = true;
+        break;
+      }
+    }
+    front += results[i].dominated == false;
+  }
+  return front;
+}
+
+void Sweep::report(bool all)
+{
+  for(uint8_t p = 0; p < count; p++)
+    printf("%s,", parameters[p].name);
+  for(uint8_t o = 0; o < SWEEP_OBJECTIVES; o++)
+    printf("%s,", objectiveNames[o]);
+  printf("pareto\n");
+  for(uint32_t i = 0; i < size; i++) {
+    if(all == false && results[i].dominated)
+      continue;
+    for(uint8_t p = 0; p < count; p++)
+      printf("%u,", results[i].values[p]);
+    for(uint8_t o = 0; o < SWEEP_OBJECTIVES; o++)
+      printf("%.2f,", results[i].objectives[o]);
+    printf("%d\n", results[i].dominated == false);
+  }
+}
@@ -0,0 +1,55 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stdint.h>
+
+static const uint8_t SWEEP_MAX_PARAMETERS = 16;
+// Objectives are minimized: water (l), energy (Wh), climate (% of time
+// out of range)
+static const uint8_t SWEEP_OBJECTIVES = 3;
+
+struct SweepParameter {
+  const char *name;
+  uint16_t minimum, maximum, step;
+};
+
+struct SweepResult {
+  uint16_t values[SWEEP_MAX_PARAMETERS];
+  float objectives[SWEEP_OBJECTIVES];
+  bool dominated;
+};
+
+// Runs one simulation with parameter values and fills objectives,
+// it is called in a forked process
+typedef bool (*SweepRun)(const uint16_t *values, float *objectives);
+
+// Search of settings space. Every point runs in its own process forked
+// from the untouched firmware image, so runs don't share any state and
+// all cores are busy. Points are a full grid of the ranges or random
+// samples of them.
+class Sweep
+{
+public:
+  Sweep(const SweepParameter *parameters, uint8_t count, SweepRun run);
+
+  // Returns count of finished points, results are allocated
+  uint32_t grid(uint8_t jobs);
+  uint32_t random(uint32_t samples, uint32_t seed, uint8_t jobs);
+
+  // Mark dominated points, returns count of Pareto optimal ones
+  uint32_t pareto(void);
+  void report(bool all);
+
+  ~Sweep();
+
+private:
+  const SweepParameter *parameters;
+  uint8_t count;
+  SweepRun run;
+  SweepResult *results;
+  uint32_t size;
+
+  uint32_t execute(uint8_t jobs);
+};
+
+#endif // __SWEEP_H__
@@ -0,0 +1,36 @@
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+#include <Arduino.h>
+
+// I2C bus with simulated devices: DS1307 clock, BH1750 light sensor
+// and PCF8574 LCD backpack
+class TwoWire
+{
+public:
+  void begin(void) {}
+  void beginTransmission(uint8_t address);
+  void beginTransmission(int address) {
+    beginTransmission((uint8_t)address);
+  }
+  uint8_t endTransmission(void);
+  uint8_t requestFrom(uint8_t address, uint8_t quantity);
+  uint8_t requestFrom(int address, int quantity) {
+    return requestFrom((uint8_t)address, (uint8_t)quantity);
+  }
+  size_t write(uint8_t data);
+  size_t write(int data) {
+    return write((uint8_t)data);
+  }
+  int available(void);
+  int read(void);
+
+private:
+  uint8_t address;
+  uint8_t txBuffer[32], txCount;
+  uint8_t rxBuffer[32], rxCount, rxIndex;
+};
+
+extern TwoWire Wire;
+
+#endif // __SIM_WIRE_H__
@@ -0,0 +1,16 @@
+#ifndef SIM_EEPROM_H
+#define SIM_EEPROM_H
+
+// EEPROM of ATmega328P, erased on start of simulation
+#include <stdint.h>
+#include <stddef.h>
+
+#define E2END 1023
+
+uint8_t eeprom_read_byte(const uint8_t *address);
+void eeprom_write_byte(uint8_t *address, uint8_t value);
+void eeprom_update_byte(uint8_t *address, uint8_t value);
+void eeprom_read_block(void *destination, const void *source, size_t size);
+void eeprom_update_block(const void *source, void *destination, size_t size);
+
+#endif // __SIM_EEPROM_H__
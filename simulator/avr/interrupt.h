@@ -0,0 +1,10 @@
+#ifndef SIM_INTERRUPT_H
+#define SIM_INTERRUPT_H
+
+// Nothing interrupts the simulated CPU
+#include <avr/io.h>
+
+#define cli() ((void)0)
+#define sei() ((void)0)
+
+#endif // __SIM_INTERRUPT_H__
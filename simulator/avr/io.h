@@ -0,0 +1,45 @@
+#ifndef SIM_IO_H
+#define SIM_IO_H
+
+// I/O registers of ATmega328P in data memory space
+#include <stdint.h>
+
+extern volatile uint8_t sim_io[0x100];
+
+#define _MMIO_BYTE(mem_addr) (sim_io[(uint8_t)(mem_addr)])
+#define _SFR_MEM_ADDR(sfr) ((uint16_t)(&(sfr) - sim_io))
+#define _BV(bit) (1 << (bit))
+
+#define PINB _MMIO_BYTE(0x23)
+#define DDRB _MMIO_BYTE(0x24)
+#define PORTB _MMIO_BYTE(0x25)
+#define PINC _MMIO_BYTE(0x26)
+#define DDRC _MMIO_BYTE(0x27)
+#define PORTC _MMIO_BYTE(0x28)
+#define PIND _MMIO_BYTE(0x29)
+#define DDRD _MMIO_BYTE(0x2A)
+#define PORTD _MMIO_BYTE(0x2B)
+#define SREG _MMIO_BYTE(0x5F)
+
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+#endif // __SIM_IO_H__
@@ -0,0 +1,34 @@
+#ifndef SIM_PGMSPACE_H
+#define SIM_PGMSPACE_H
+
+// Flash is ordinary memory on the host
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+#define pgm_read_dword(address) (*(const uint32_t *)(address))
+#define pgm_read_ptr(address) (*(void * const *)(address))
+#define memcpy_P memcpy
+#define strcpy_P strcpy
+#define strlen_P strlen
+#define strcmp_P strcmp
+
+// Debug output of the sketch is shown in verbose mode only
+int sim_printf(const char *format, ...);
+#define printf_P sim_printf
+
+// Sketch redirects stdout to Serial, keep the host one
+extern FILE *sim_stdout, *sim_stderr;
+#undef stdout
+#undef stderr
+#define stdout sim_stdout
+#define stderr sim_stderr
+#define fdev_setup_stream(stream, put, get, rwflag) ((void)(put))
+#define _FDEV_SETUP_WRITE 2
+
+#endif // __SIM_PGMSPACE_H__
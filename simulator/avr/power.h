@@ -0,0 +1 @@
+// Power reduction is simulated by LowPower substitute
@@ -0,0 +1 @@
+// Sleep modes are simulated by LowPower substitute
@@ -0,0 +1,14 @@
+#ifndef SIM_WDT_H
+#define SIM_WDT_H
+
+#define WDTO_15MS 0
+#define WDTO_1S 6
+#define WDTO_2S 7
+#define WDTO_4S 8
+#define WDTO_8S 9
+
+#define wdt_enable(timeout) ((void)0)
+#define wdt_disable() ((void)0)
+#define wdt_reset() ((void)0)
+
+#endif // __SIM_WDT_H__
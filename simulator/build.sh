@@ -0,0 +1,15 @@
+#!/bin/sh
+# Build host simulator of the sketch: simulator/build/hydroponics-sim
+set -e
+cd "$(dirname "$0")"
+mkdir -p build
+# prototypes of sketch functions, Arduino IDE generates them the same way
+grep -E '^[A-Za-z_][A-Za-z0-9_<>:* ]* [*&]?[A-Za-z_][A-Za-z0-9_]*\([^;]*\)[ ]*\{' \
+  ../hydroponics.ino | grep -vE '^(static|if|else|while|for|switch)' | \
+  sed 's/[ ]*{.*$/;/' > build/prototypes.h
+${CXX:-g++} -std=gnu++11 ${SIMFLAGS:--O2} -Wall \
+  -D__AVR__ -D__AVR_ATmega328P__ -DSIMULATOR -I. -Ibuild \
+  Main.cpp Simulator.cpp Greenhouse.cpp Drivers.cpp Sweep.cpp \
+  ../RelayBank.cpp ../HistoryLog.cpp ../OneButton.cpp \
+  ../LiquidCrystal_I2C.cpp ../RTClib.cpp ../BH1750.cpp \
+  -o ${SIMOUT:-build/hydroponics-sim}
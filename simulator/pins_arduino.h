@@ -0,0 +1 @@
+// Pin tables aren't used by the simulator
@@ -0,0 +1,53 @@
+#!/bin/sh
+# Build and run host tests of the sketch modules: simulator/build/tests
+cd "$(dirname "$0")"
+mkdir -p build/tests
+FLAGS="-std=gnu++11 ${SIMFLAGS:--O2} -Wall -DARDUINO=105 \
+  -D__AVR__ -D__AVR_ATmega328P__ -DSIMULATOR -I. -Ibuild"
+# fill locals with a pattern, so members the firmware gets zeroed as
+# globals fail every run instead of now and then
+if echo "int main(){}" | ${CXX:-g++} -x c++ -ftrivial-auto-var-init=pattern \
+    - -o /dev/null 2>/dev/null; then
+  FLAGS="$FLAGS -ftrivial-auto-var-init=pattern"
+fi
+# simulated Arduino core, I2C bus and EEPROM
+CORE="Simulator.cpp Greenhouse.cpp ../RTClib.cpp"
+# drivers of sensors, sleep and uptime read the model
+MODEL="$CORE Drivers.cpp"
+failed=0
+
+# test name, its defines and sources it needs besides tests/name.cpp
+run() {
+  name=$1
+  defines=$2
+  shift 2
+  if ${CXX:-g++} $FLAGS $defines tests/$name.cpp "$@" -o build/tests/$name; then
+    ./build/tests/$name || failed=1
+  else
+    failed=1
+  fi
+}
+
+run ControllerTest "" $MODEL
+# zones of a board with 8 zones and the sketch built for it, the model
+# has relays of the first zone
+run ControllerTest "-DZONES=8" $MODEL
+if SIMFLAGS="${SIMFLAGS:--O2} -DZONES=8" SIMOUT=build/tests/hydroponics-sim-8 \
+    ./build.sh; then
+  ./build/tests/hydroponics-sim-8 -d 2 > build/tests/zones-8.txt || failed=1
+else
+  failed=1
+fi
+# home screen of small and big panel
+run LayoutTest "-DLCD_COLS=16 -DLCD_ROWS=2" $MODEL
+run LayoutTest "-DLCD_COLS=20 -DLCD_ROWS=4" $MODEL
+run HistoryTest "" $CORE
+run HistoryLogTest "" ../HistoryLog.cpp $CORE
+run LcdFormatTest "" $CORE
+# every CRC kernel: bitwise, table, nibble
+for kernel in 0 1 2; do
+  run CrcTest "-DONEWIRE_CRC16=1 -DONEWIRE_CRC8_TABLE=$kernel \
+    -DONEWIRE_CRC16_TABLE=$kernel" ../OneWire.cpp $CORE
+done
+
+exit $failed
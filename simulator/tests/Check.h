@@ -0,0 +1,24 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+// Host tests print failed checks and return count of them from main()
+static int checks, failures;
+
+#define CHECK(condition) do { \
+    checks++; \
+    if(!(condition)) { \
+      printf("%s:%d: Error: CHECK(%s) failed.\n", __FILE__, __LINE__, \
+        #condition); \
+      failures++; \
+    } \
+  } while(0)
+
+static int report(const char *_name)
+{
+  printf("%s: %d checks, %d failed.\n", _name, checks, failures);
+  return failures != 0;
+}
+
+#endif // __CHECK_H__
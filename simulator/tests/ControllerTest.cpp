@@ -0,0 +1,147 @@
+// Two controllers in one process. Every one has own settings, profiles,
+// states, alarms, rules and hardware, they don't share any global.
+// test.sh runs it with one zone and with ZONES=8 too.
+
+#include <Arduino.h>
+#include "../../Controller.h"
+#include "Check.h"
+
+// Hardware of one controller, relays are bits of outputs
+class TestHal
+{
+public:
+  unsigned long now;
+  uint32_t outputs;
+  uint8_t beeps;
+
+  TestHal() : now(0), outputs(0), beeps(0) {}
+
+  unsigned long seconds() {
+    return now;
+  }
+  uint8_t hour() {
+    return 12;
+  }
+  uint8_t minute() {
+    return 0;
+  }
+  bool relay(uint8_t _output, bool _on) {
+    if(_on)
+      outputs |= 1UL << _output;
+    else
+      outputs &= ~(1UL << _output);
+    return true;
+  }
+  uint8_t zoneRelay(uint8_t _zone, uint8_t _relay) {
+    return _zone*3 + _relay - PUMP_MISTING;
+  }
+  void beep(uint8_t _count) {
+    beeps += _count;
+  }
+  void settingsChanged() {}
+};
+
+// Bits of states of all zones, outputs of lamps of all zones
+static const uint16_t ALL_ZONES = (1 << ZONES) - 1;
+
+static uint32_t lampOutputs()
+{
+  uint32_t outputs = 0;
+  for(uint8_t z=0; z<ZONES; z++)
+    outputs |= 1UL << (z*3 + 2);
+  return outputs;
+}
+
+// Lamp keeps light day, zones work in normal mode
+const Rule testRules[] PROGMEM = {
+  { RULE_LAMP, 1, IN_LIGHT_DAY, 0, 0, 0, 0, LUX_ANY,
+    TEMP_ANY_MIN, TEMP_ANY_MAX, RULE_ANY },
+};
+
+// Everything one controller works with
+struct Context
+{
+  TestHal hal;
+  SettingsStruct settings;
+  Profiles profiles;
+  States states;
+  Alarms alarms;
+  RuleTable rules;
+  Controller<TestHal> controller;
+
+  Context(uint8_t _wateringPeriod, uint8_t _lightDuration) : settings(),
+      profiles(settings), alarms(LATCHING_ALARMS),
+      rules(testRules, sizeof(testRules)/sizeof(Rule)),
+      controller(hal, settings, profiles, states, alarms, rules) {
+    settings.zones[0].wateringDuration = 1;
+    settings.zones[0].wateringPeriod = _wateringPeriod;
+    settings.lightDayStart = 6*60;
+    settings.lightDayDuration = _lightDuration;
+    settings.subsTempMinimum = 10;
+    settings.silentMorning = 0;
+    settings.silentEvening = 24;
+    profiles.begin();
+    controller.zones[0].substrateTemp = 20;
+  }
+
+  void minute() {
+    hal.now += 60;
+    controller.doWork();
+    controller.doLight();
+  }
+
+  void seconds(uint8_t _count) {
+    while(_count--) {
+      hal.now++;
+      controller.update();
+    }
+  }
+};
+
+int main()
+{
+  Context a(1, 14), b(90, 0);
+
+  a.minute();
+  b.minute();
+  a.seconds(3);
+  b.seconds(3);
+
+  // first one waters by its period and keeps light day
+  CHECK(a.states[PUMP_WATERING] == 1);
+  CHECK(a.states[LAMP] == ALL_ZONES);
+  CHECK(a.hal.outputs == (lampOutputs() | 2));
+  CHECK(a.hal.beeps == ONE_BEEP);
+  CHECK(a.alarms.isActive(WARNING_WATERING));
+  CHECK(a.states[WATERING] == 0);
+  // second one waits, its lamp is off
+  CHECK(b.states[PUMP_WATERING] == 0);
+  CHECK(b.states[LAMP] == 0);
+  CHECK(b.hal.outputs == 0);
+  CHECK(b.hal.beeps == 0);
+  CHECK(b.alarms.isActive(WARNING_WATERING) == false);
+  CHECK(b.states[WATERING] == 89);
+
+  // settings and profiles are separate too
+  b.settings.lightDayDuration = 14;
+  b.minute();
+  CHECK(b.states[LAMP] == ALL_ZONES);
+  a.settings.lightDayDuration = 0;
+  a.minute();
+  CHECK(a.states[LAMP] == 0);
+  CHECK(b.states[LAMP] == ALL_ZONES);
+
+#if ZONES > 1
+  // the last zone waters by own schedule, the first one waits
+  Context c(90, 0);
+  c.settings.zones[ZONES-1].wateringDuration = 1;
+  c.settings.zones[ZONES-1].wateringPeriod = 1;
+  c.controller.zones[ZONES-1].substrateTemp = 20;
+  c.minute();
+  c.seconds(3);
+  CHECK(c.states[PUMP_WATERING] == 1 << (ZONES-1));
+  CHECK(c.hal.outputs == 1UL << ((ZONES-1)*3 + 1));
+#endif
+
+  return report("ControllerTest");
+}
@@ -0,0 +1,118 @@
+// CRC kernels of OneWire against bitwise references of Maxim
+// Application Note 27 over random buffers, and their speed. Kernels are
+// selected by ONEWIRE_CRC8_TABLE and ONEWIRE_CRC16_TABLE, test.sh
+// builds it once per kernel.
+
+#include <Arduino.h>
+#include <time.h>
+#include "../../OneWire.h"
+#include "Check.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#endif
+
+static const char *kernels[] = {"bitwise", "table", "nibble"};
+
+// Shift register of reflected polynomial x^8+x^5+x^4+1, bit by bit
+static uint8_t crc8Reference(const uint8_t *_data, uint16_t _length)
+{
+  uint8_t crc = 0;
+  for(uint16_t i=0; i<_length; i++) {
+    for(uint8_t b=0; b<8; b++) {
+      bool feedback = ((crc ^ (_data[i] >> b)) & 1) != 0;
+      crc >>= 1;
+      if(feedback)
+        crc ^= 0x8C;
+    }
+  }
+  return crc;
+}
+
+// Shift register of reflected polynomial x^16+x^15+x^2+1, bit by bit
+static uint16_t crc16Reference(const uint8_t *_data, uint16_t _length,
+  uint16_t _crc)
+{
+  for(uint16_t i=0; i<_length; i++) {
+    for(uint8_t b=0; b<8; b++) {
+      bool feedback = ((_crc ^ (_data[i] >> b)) & 1) != 0;
+      _crc >>= 1;
+      if(feedback)
+        _crc ^= 0xA001;
+    }
+  }
+  return _crc;
+}
+
+// Host time of one byte, in cycles where the CPU counter is known
+static void benchmark(const char *_name, bool _crc16)
+{
+  static uint8_t buffer[256];
+  const uint16_t passes = 4096;
+  for(uint16_t i=0; i<sizeof(buffer); i++)
+    buffer[i] = rand();
+  volatile uint16_t sink = 0;
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+#ifdef CYCLES
+  uint64_t cycles = CYCLES();
+#endif
+  for(uint16_t p=0; p<passes; p++) {
+    // length keeps the loop from being hoisted
+    if(_crc16)
+      sink = sink + OneWire::crc16(buffer, sizeof(buffer) - (p & 1));
+    else
+      sink = sink + OneWire::crc8(buffer, sizeof(buffer) - 1 - (p & 1));
+  }
+#ifdef CYCLES
+  cycles = CYCLES() - cycles;
+#endif
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double bytes = (double)passes*(sizeof(buffer) - 1);
+  double ns = (end.tv_sec - start.tv_sec)*1e9 + (end.tv_nsec - start.tv_nsec);
+#ifdef CYCLES
+  printf("%s %s: %.2f ns/byte, %.3f bytes/cycle.\n", _name,
+    kernels[_crc16 ? ONEWIRE_CRC16_TABLE : ONEWIRE_CRC8_TABLE],
+    ns/bytes, bytes/cycles);
+#else
+  printf("%s %s: %.2f ns/byte.\n", _name,
+    kernels[_crc16 ? ONEWIRE_CRC16_TABLE : ONEWIRE_CRC8_TABLE], ns/bytes);
+#endif
+}
+
+int main()
+{
+  uint8_t buffer[64];
+  srand(1);
+
+  // ROM code of the board ends with CRC8 of first 7 bytes
+  const uint8_t rom[8] = {0x28, 0x28, 0x88, 0xD6, 0x05, 0x00, 0x00, 0xC1};
+  CHECK(OneWire::crc8(rom, 7) == rom[7]);
+  CHECK(OneWire::crc8(rom, 8) == 0);
+  // check value of CRC-16/ARC
+  CHECK(OneWire::crc16((const uint8_t *)"123456789", 9) == 0xBB3D);
+
+  for(uint16_t n=0; n<1000; n++) {
+    uint8_t length = rand() % (sizeof(buffer) + 1);
+    for(uint8_t i=0; i<length; i++)
+      buffer[i] = rand();
+    CHECK(OneWire::crc8(buffer, length) == crc8Reference(buffer, length));
+    uint16_t seed = n & 1 ? rand() : 0;
+    uint16_t crc = OneWire::crc16(buffer, length, seed);
+    CHECK(crc == crc16Reference(buffer, length, seed));
+    // received CRC16 is inverted
+    uint8_t inverted[2] = {(uint8_t)~crc, (uint8_t)(~crc >> 8)};
+    CHECK(OneWire::check_crc16(buffer, length, inverted, seed));
+    inverted[n & 1] ^= 1 << (n % 8);
+    CHECK(OneWire::check_crc16(buffer, length, inverted, seed) == false);
+  }
+
+  benchmark("crc8", false);
+  benchmark("crc16", true);
+
+  char name[32];
+  snprintf(name, sizeof(name), "CrcTest %s/%s",
+    kernels[ONEWIRE_CRC8_TABLE], kernels[ONEWIRE_CRC16_TABLE]);
+  return report(name);
+}
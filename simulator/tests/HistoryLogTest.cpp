@@ -0,0 +1,125 @@
+// History log round trip over EEPROM, DS1307 NVRAM and file backends.
+// Records are read back block by block after the log has wrapped and
+// after restart, compression and host time of append are reported.
+
+#include <Arduino.h>
+#include <time.h>
+#include "../../HistoryLog.h"
+#include "Simulator.h"
+#include "Check.h"
+
+static const uint16_t INTERVAL = 3600;
+static const uint16_t RECORDS = 400;
+
+struct Record {
+  uint32_t time;
+  uint16_t values[LOG_SERIES];
+};
+
+static Record records[RECORDS];
+
+// Hourly series like the sketch logs: air and substrate temperature,
+// humidity, light and relay bits of two values, with a power cut every
+// 50 hours
+static void generate(void)
+{
+  uint32_t time = 1459468800;
+  srand(1);
+  for(uint16_t r=0; r<RECORDS; r++) {
+    uint8_t hour = r % 24;
+    bool day = hour >= 6 && hour < 20;
+    records[r].time = time;
+    records[r].values[0] = 20 + (day ? 4 : 0) + rand() % 2;
+    records[r].values[1] = 60 - (day ? 10 : 0) + rand() % 3;
+    records[r].values[2] = 18 + (day ? 1 : 0);
+    records[r].values[3] = day ? 8000 + rand() % 4000 : 0;
+    records[r].values[4] = (day ? 4 : 0) | rand() % 4;
+    records[r].values[5] = rand() % 8 == 0 ? 2 : 0;
+    time += r % 50 == 49 ? 3*INTERVAL : INTERVAL;
+  }
+}
+
+// Decoded records are the newest appended ones, in order of time
+static uint16_t readBack(HistoryLog &_log, uint16_t _appended)
+{
+  static uint16_t values[LOG_MAX_RECORDS*LOG_SERIES];
+  uint16_t decoded = 0;
+  uint16_t next = _appended;
+  for(uint8_t ago=0; ago<_log.blocks(); ago++) {
+    uint32_t time;
+    uint8_t count = _log.read(ago, &time, values, LOG_MAX_RECORDS);
+    if(count == 0)
+      break;
+    CHECK(next >= count);
+    if(next < count)
+      return decoded;
+    next -= count;
+    for(uint8_t r=0; r<count; r++) {
+      const Record &expected = records[next + r];
+      CHECK(time + r*INTERVAL == expected.time);
+      CHECK(memcmp(values + r*LOG_SERIES, expected.values,
+        sizeof(expected.values)) == 0);
+    }
+    decoded += count;
+  }
+  return decoded;
+}
+
+static void roundTrip(const char *_name, LogStorage *_storage,
+  uint8_t _blockSize)
+{
+  HistoryLog log(_storage, _blockSize, INTERVAL);
+  log.begin();
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(uint16_t r=0; r<RECORDS; r++)
+    CHECK(log.append(records[r].time, records[r].values));
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double ns = (end.tv_sec - start.tv_sec)*1e9 +
+    (end.tv_nsec - start.tv_nsec);
+
+  uint16_t decoded = readBack(log, RECORDS);
+  // the newest block at least, all blocks but the open one are full
+  CHECK(decoded > (log.blocks() - 1)*(_blockSize - LOG_HEADER_SIZE)/
+    (LOG_SERIES*3));
+
+  // restart finds the newest block
+  HistoryLog restarted(_storage, _blockSize, INTERVAL);
+  restarted.begin();
+  CHECK(readBack(restarted, RECORDS) == decoded);
+
+  printf("%s: %d blocks, %u records kept, %.2f bytes/record, "
+    "%.0f%% of raw, %.0f ns/append.\n", _name, log.blocks(), decoded,
+    (double)log.encodedBytes/RECORDS, 100.0*log.encodedBytes/log.rawBytes,
+    ns/RECORDS);
+}
+
+int main()
+{
+  // blank EEPROM and clock chip
+  sim.begin(1, 1459468800);
+  generate();
+
+  // the sketch keeps the log after rules overlay of EEPROM
+  EepromLogStorage eeprom(384, E2END+1-384);
+  roundTrip("eeprom", &eeprom, 64);
+
+  RTC_DS1307 rtc;
+  NvramLogStorage nvram(&rtc);
+  roundTrip("nvram", &nvram, 28);
+
+  const char *path = "build/tests/HistoryLog.bin";
+  remove(path);
+  {
+    FileLogStorage file(path, 1024);
+    roundTrip("file", &file, 64);
+  }
+  // blocks are kept in the file
+  FileLogStorage reopened(path, 1024);
+  HistoryLog log(&reopened, 64, INTERVAL);
+  log.begin();
+  CHECK(readBack(log, RECORDS) > 0);
+  remove(path);
+
+  return report("HistoryLogTest");
+}
@@ -0,0 +1,122 @@
+// Sensor history tiers: trend, rate and extremes of the raw tier, exact
+// last quarter and hour, ranges of older hours in 8-bit fixed point.
+// Size of the five series of the sketch and host time of update are
+// reported.
+
+#include <Arduino.h>
+#include <time.h>
+#include "../../History.h"
+#include "Check.h"
+
+// Hour of minutes from _from to _to and back, min, max and avg are known
+template<typename H>
+static void rampHour(H &_history, uint16_t _from, uint16_t _to)
+{
+  for(uint8_t m=0; m<60; m++) {
+    uint8_t step = m < 30 ? m : 59-m;
+    _history.update(_from + (uint32_t)(_to - _from)*step/29);
+  }
+}
+
+// Range of hour ago in the ring
+template<typename H>
+static bool hourRangeIs(H &_history, uint8_t _ago, uint16_t _min,
+  uint16_t _max)
+{
+  return _history.hourMin(_ago) == _min && _history.hourMax(_ago) == _max;
+}
+
+static void rawTier()
+{
+  History<uint8_t> history;
+  CHECK(history.trend() == 0);
+  CHECK(history.rate() == 0);
+  for(uint8_t m=0; m<10; m++)
+    history.update(20 + m/3);
+  // 20 to 23 in 9 minutes
+  CHECK(history.last() == 23);
+  CHECK(history.minute(9) == 20);
+  CHECK(history.trend() == 1);
+  CHECK(history.rate() == 3*60/9);
+  // the window is 15 minutes
+  for(uint8_t m=0; m<15; m++)
+    history.update(30 - m);
+  CHECK(history.trend() == -1);
+  CHECK(history.rate() == -14*60/14);
+  CHECK(history.todayMin() == 16);
+  CHECK(history.todayMax() == 30);
+  history.startDay();
+  history.update(25);
+  CHECK(history.lastDayMin() == 16);
+  CHECK(history.lastDayMax() == 30);
+  CHECK(history.todayMin() == 25);
+  CHECK(history.todayMax() == 25);
+}
+
+static void hourTier()
+{
+  History<uint8_t> history;
+  CHECK(history.hoursCount() == 0);
+  rampHour(history, 10, 39);
+  CHECK(history.hoursCount() == 1);
+  // quarter 4 goes down from 24 to 10
+  Aggregate<uint8_t> quarter = history.quarter();
+  CHECK(quarter.min == 10);
+  CHECK(quarter.max == 24);
+  CHECK(quarter.avg == (24+10)*15/2/15);
+  Aggregate<uint8_t> hour = history.hour();
+  CHECK(hour.min == 10);
+  CHECK(hour.max == 39);
+  CHECK(hourRangeIs(history, 0, 10, 39));
+  // ring keeps the last 16 hours, the newest is 0 ago
+  for(uint8_t h=1; h<20; h++)
+    rampHour(history, h, h+10);
+  CHECK(history.hoursCount() == HISTORY_HOURS);
+  CHECK(history.hour().min == 19);
+  CHECK(history.hour().max == 29);
+  CHECK(hourRangeIs(history, 0, 19, 29));
+  CHECK(hourRangeIs(history, 15, 4, 14));
+}
+
+// Light keeps exact last hour, graph ranges are rounded outwards to
+// 256 lux
+static void fixedPoint()
+{
+  History<uint16_t, uint32_t, 8> light;
+  rampHour(light, 1000, 12000);
+  CHECK(light.hour().min == 1000);
+  CHECK(light.hour().max == 12000);
+  CHECK(hourRangeIs(light, 0, 768, 12032));
+  rampHour(light, 0, 65535);
+  CHECK(light.hour().max == 65535);
+  CHECK(hourRangeIs(light, 0, 0, 65280));
+  CHECK(hourRangeIs(light, 1, 768, 12032));
+}
+
+int main()
+{
+  rawTier();
+  hourTier();
+  fixedPoint();
+
+  // series of the sketch: air, humidity, substrate and computer
+  // temperature, light
+  static History<uint8_t> temperature;
+  static History<uint16_t, uint32_t, 8> light;
+  unsigned int bytes = 4*sizeof(temperature) + sizeof(light);
+  const uint32_t minutes = 100000;
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(uint32_t m=0; m<minutes; m++) {
+    temperature.update(20 + m % 7);
+    light.update(m % 1440 * 40);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double ns = (end.tv_sec - start.tv_sec)*1e9 +
+    (end.tv_nsec - start.tv_nsec);
+  printf("history: %u bytes of 5 series, %.1f ns/update.\n", bytes,
+    ns/minutes/2);
+  CHECK(bytes < 450);
+
+  return report("HistoryTest");
+}
@@ -0,0 +1,104 @@
+// Home screen of the sketch drawn into a VirtualDisplay of LCD_COLS x
+// LCD_ROWS. test.sh builds it for 16x2, which rotates pages of widgets
+// under the sticky status and clock, and for 20x4, which shows all of
+// them at once.
+
+#define LCD_VIRTUAL
+#include <Arduino.h>
+#include "../../LcdMenu.h"
+#include "Simulator.h"
+#include "Check.h"
+
+LcdMenu menu;
+
+// Text at column of row, clock colon blinks so ':' is taken as any
+static bool at(uint8_t _col, uint8_t _row, const char *_text)
+{
+  const char *line = display.line(_row);
+  for(uint8_t i=0; _text[i] != '\0'; i++) {
+    if(_col + i >= display.cols)
+      return false;
+    if(_text[i] != ':' && line[_col + i] != _text[i])
+      return false;
+  }
+  return true;
+}
+
+// Widgets which share a row on some page are a blank column apart
+static bool separated()
+{
+  for(uint8_t a=0; a<layout.count; a++) {
+    for(uint8_t b=0; b<layout.count; b++) {
+      if(a == b || layout.row[a] != layout.row[b] ||
+          layout.col[a] > layout.col[b])
+        continue;
+      for(uint8_t p=0; p<layout.pages; p++) {
+        if(layout.visible(a, p) && layout.visible(b, p) &&
+            layout.col[a] + pgm_read_byte(&widgetWidths[a]) >= layout.col[b])
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+static void print(uint8_t _page)
+{
+  printf("%dx%d page %d:\n", LCD_COLS, LCD_ROWS, _page);
+  display.print(stdout);
+}
+
+int main()
+{
+  sim.begin(1, 1459468800);
+  menu.begin();
+  clock = DateTime(2016, 4, 1, 12, 34, 0);
+  states[AIR_TEMP] = 24;
+  states[HUMIDITY] = 55;
+  states[SUBSTRATE_TEMP] = 19;
+  states[LIGHT] = 1200;
+  states[COMPUTER_TEMP] = 41;
+  // custom chars are digits: 0 is celcium, 2 humidity, 3 temperature,
+  // 5 lamp
+  menu.show();
+
+#if LCD_ROWS == 2
+  print(0);
+  CHECK(layout.pages == 4);
+  CHECK(separated());
+  CHECK(at(0, 0, "Sleeping   12:34"));
+  CHECK(at(0, 1, "Air: 3 240 2 55%"));
+  const char *pages[] = {
+    "Sub: 3 190      ", "Light: 5 1200lux", "PC: 3 410       "
+  };
+  for(uint8_t p=1; p<4; p++) {
+    // next page comes every 4 screens
+    for(uint8_t i=0; i<4; i++)
+      menu.show();
+    print(p);
+    // status and clock are sticky
+    CHECK(at(0, 0, "Sleeping   12:34"));
+    CHECK(at(0, 1, pages[p-1]));
+  }
+  // back to the first page
+  for(uint8_t i=0; i<4; i++)
+    menu.show();
+  CHECK(at(0, 1, "Air: 3 240 2 55%"));
+#else
+  print(0);
+  CHECK(layout.pages == 1);
+  CHECK(separated());
+  CHECK(at(0, 0, "Sleeping   12:34    "));
+  CHECK(at(0, 1, "Air: 3 240 2 55%    "));
+  CHECK(at(0, 2, "Sub: 3 190 PC: 3 410"));
+  CHECK(at(0, 3, "Light: 5 1200lux    "));
+  // nothing moves on next pages
+  for(uint8_t i=0; i<4; i++)
+    menu.show();
+  CHECK(at(0, 2, "Sub: 3 190 PC: 3 410"));
+#endif
+
+  char name[32];
+  snprintf(name, sizeof(name), "LayoutTest %dx%d", LCD_COLS, LCD_ROWS);
+  return report(name);
+}
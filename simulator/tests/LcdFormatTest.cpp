@@ -0,0 +1,274 @@
+// Field renderers of LcdFormat drawn into a VirtualDisplay against exact
+// text, blink regions over frames, and the same screens through the
+// former fprintf_P stream with lcd_putchar: equal text, host cycles and
+// stack bytes per screen.
+
+#include <Arduino.h>
+#include <time.h>
+#include <ucontext.h>
+#include "../../LcdFormat.h"
+#include "Check.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#endif
+
+// custom chars are shown as digits: 0 is celcium, 2 humidity,
+// 3 temperature
+static const uint8_t C_CELCIUM = 0;
+static const uint8_t C_HUMIDITY = 2;
+static const uint8_t C_TEMP = 3;
+
+VirtualDisplay display(16, 2);
+LcdFormat out(&display);
+
+// Former output: printf formats into a stream and every char goes
+// through the blink markup parser
+static bool charErase, textErase, textBlink;
+static uint8_t blinkCursor, blinkPos;
+static FILE *lcd_out;
+
+static ssize_t lcd_write(void *, const char *_buffer, size_t _size)
+{
+  for(size_t i=0; i<_size; i++) {
+    char c = _buffer[i];
+    switch(c) {
+      case '\n':
+        display.setCursor(0,1);
+        blinkCursor = 0;
+        break;
+      case '{':
+        blinkCursor++;
+        if(textBlink && textErase &&
+            (blinkPos == false || blinkPos == blinkCursor))
+          charErase = true;
+        break;
+      case '}':
+        if(blinkPos == false || blinkPos == blinkCursor) {
+          charErase = false;
+          textErase = !textErase;
+        }
+        break;
+      default:
+        if(charErase)
+          c = ' ';
+        display.write(c);
+    }
+  }
+  return _size;
+}
+
+// Values of screens
+static uint8_t hour = 12, minute = 34, day = 1, month = 4;
+static uint16_t year = 2016;
+static uint8_t airTemp = 24, humidity = 55;
+
+static void homeScreen()
+{
+  out.home();
+  out.text_P(PSTR("Sleeping   "));
+  out.number(hour, 2, '0');
+  out.text_P(PSTR("{:}"));
+  out.number(minute, 2, '0');
+  out.newline();
+  out.text_P(PSTR("Air: "));
+  out.text(C_TEMP);
+  out.text(' ');
+  out.number(airTemp, 2);
+  out.text(C_CELCIUM);
+  out.text(' ');
+  out.text(C_HUMIDITY);
+  out.text(' ');
+  out.number(humidity, 2);
+  out.text('%');
+}
+
+static void homeScreenPrintf()
+{
+  display.home();
+  blinkCursor = 0;
+  fprintf(lcd_out, PSTR("Sleeping  "));
+  fprintf(lcd_out, PSTR(" %02d{:}%02d\n"), hour, minute);
+  fprintf(lcd_out, PSTR("Air: %c "), C_TEMP);
+  fprintf(lcd_out, PSTR("%2d%c "), airTemp, C_CELCIUM);
+  fprintf(lcd_out, PSTR("%c "), C_HUMIDITY);
+  fprintf(lcd_out, PSTR("%2d%%"), humidity);
+  fflush(lcd_out);
+}
+
+static void clockScreen()
+{
+  out.home();
+  out.text_P(PSTR("Setting time    \n"));
+  out.field(hour, 2, '0');
+  out.text(':');
+  out.field(minute, 2, '0');
+  out.text(' ');
+  out.field(day, 2, '0');
+  out.text('-');
+  out.field(month, 2, '0');
+  out.text('-');
+  out.field(year, 4);
+}
+
+static void clockScreenPrintf()
+{
+  display.home();
+  blinkCursor = 0;
+  fprintf(lcd_out, PSTR("Setting time    \n{%02d}:{%02d} {%02d}-{%02d}-{%4d}"),
+    hour, minute, day, month, year);
+  fflush(lcd_out);
+}
+
+static bool shows(const char *_line0, const char *_line1)
+{
+  bool same = strcmp(display.line(0), _line0) == 0 &&
+    strcmp(display.line(1), _line1) == 0;
+  if(!same)
+    display.print(stdout);
+  return same;
+}
+
+static void numbers()
+{
+  const struct {
+    uint16_t value;
+    uint8_t width;
+    char pad;
+    const char *text;
+  } cases[] = {
+    {7, 3, ' ', "  7"}, {0, 3, ' ', "  0"}, {5, 2, '0', "05"},
+    {42, 2, '0', "42"}, {1200, 4, ' ', "1200"}, {65535, 5, ' ', "65535"},
+    // longer numbers aren't cut
+    {1234, 2, ' ', "1234"}, {9, 1, ' ', "9"}, {0, 1, '0', "0"}
+  };
+  for(uint8_t i=0; i<sizeof(cases)/sizeof(cases[0]); i++) {
+    display.clear();
+    out.home();
+    out.number(cases[i].value, cases[i].width, cases[i].pad);
+    CHECK(out.column == strlen(cases[i].text));
+    CHECK(strncmp(display.line(0), cases[i].text,
+      strlen(cases[i].text)) == 0);
+  }
+  display.clear();
+  out.home();
+  out.time(9, 5);
+  out.clear(8);
+  CHECK(shows("09:05           ", "                "));
+}
+
+// Blinking regions are erased in every second frame, all of them or
+// the one of blinkPos
+static void blink()
+{
+  display.clear();
+  out.textBlink = true;
+  out.blinkPos = false;
+  homeScreen();
+  CHECK(shows("Sleeping   12:34", "Air: 3 240 2 55%"));
+  homeScreen();
+  CHECK(shows("Sleeping   12 34", "Air: 3 240 2 55%"));
+
+  // the year is edited
+  out.blinkPos = 5;
+  clockScreen();
+  CHECK(shows("Setting time    ", "12:34 01-04-2016"));
+  clockScreen();
+  CHECK(shows("Setting time    ", "12:34 01-04-    "));
+  out.blinkPos = false;
+}
+
+// The former stream draws the same screens
+static void printfPath()
+{
+  textBlink = true;
+  blinkPos = false;
+  textErase = false;
+  display.clear();
+  homeScreenPrintf();
+  CHECK(shows("Sleeping   12:34", "Air: 3 240 2 55%"));
+  homeScreenPrintf();
+  CHECK(shows("Sleeping   12 34", "Air: 3 240 2 55%"));
+  blinkPos = 5;
+  textErase = false;
+  clockScreenPrintf();
+  CHECK(shows("Setting time    ", "12:34 01-04-2016"));
+  clockScreenPrintf();
+  CHECK(shows("Setting time    ", "12:34 01-04-    "));
+}
+
+// Stack of screen: it runs on its own painted stack, bytes which aren't
+// the paint any more were used
+static const uint16_t STACK_SIZE = 16384;
+static const uint8_t STACK_PAINT = 0xA5;
+static uint8_t stack[STACK_SIZE];
+static ucontext_t mainContext, screenContext;
+static void (*screenToRun)();
+
+static void runScreen()
+{
+  screenToRun();
+}
+
+static uint16_t stackBytes(void (*_screen)())
+{
+  memset(stack, STACK_PAINT, sizeof(stack));
+  screenToRun = _screen;
+  getcontext(&screenContext);
+  screenContext.uc_stack.ss_sp = stack;
+  screenContext.uc_stack.ss_size = sizeof(stack);
+  screenContext.uc_link = &mainContext;
+  makecontext(&screenContext, runScreen, 0);
+  swapcontext(&mainContext, &screenContext);
+  uint16_t unused = 0;
+  while(unused < STACK_SIZE && stack[unused] == STACK_PAINT)
+    unused++;
+  return STACK_SIZE - unused;
+}
+
+// Host time of screen, in cycles where the CPU counter is known
+static void benchmark(const char *_name, void (*_screen)())
+{
+  const uint16_t passes = 20000;
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+#ifdef CYCLES
+  uint64_t cycles = CYCLES();
+#endif
+  for(uint16_t i=0; i<passes; i++)
+    _screen();
+#ifdef CYCLES
+  cycles = CYCLES() - cycles;
+#endif
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double ns = (end.tv_sec - start.tv_sec)*1e9 +
+    (end.tv_nsec - start.tv_nsec);
+  printf("%s: %.0f ns/screen", _name, ns/passes);
+#ifdef CYCLES
+  printf(", %.0f cycles/screen", (double)cycles/passes);
+#endif
+  printf(", %u stack bytes.\n", stackBytes(_screen));
+}
+
+int main()
+{
+  cookie_io_functions_t functions = {NULL, lcd_write, NULL, NULL};
+  lcd_out = fopencookie(NULL, "w", functions);
+  setvbuf(lcd_out, NULL, _IONBF, 0);
+  display.begin();
+
+  numbers();
+  blink();
+  printfPath();
+
+  out.textBlink = false;
+  textBlink = false;
+  benchmark("home LcdFormat", homeScreen);
+  benchmark("home fprintf", homeScreenPrintf);
+  benchmark("clock LcdFormat", clockScreen);
+  benchmark("clock fprintf", clockScreenPrintf);
+
+  fclose(lcd_out);
+  return report("LcdFormatTest");
+}
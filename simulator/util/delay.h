@@ -0,0 +1,9 @@
+#ifndef SIM_DELAY_H
+#define SIM_DELAY_H
+
+#include <Arduino.h>
+
+#define _delay_ms(ms) delay(ms)
+#define _delay_us(us) delayMicroseconds(us)
+
+#endif // __SIM_DELAY_H__